@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/// Runs given function several times and returns the best wall time in milliseconds.
+template <typename F>
+double measure(F&& f, int repeats = 3) {
+    double best = 0;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = Clock::now();
+        f();
+        auto end = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (i == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+/// Thread counts to benchmark with: 1, 2, 4 ... up to the hardware concurrency.
+inline std::vector<size_t> threadCounts() {
+    const size_t hw = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < hw; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(hw);
+    return counts;
+}
+
+inline void report(const std::string& name, size_t threads, double ms, double baseline) {
+    std::printf("%-32s threads: %3zu  time: %9.2f ms  speedup: %5.2fx\n", name.c_str(), threads, ms, baseline / ms);
+}
+
+} // namespace bench
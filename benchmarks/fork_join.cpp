@@ -0,0 +1,88 @@
+#include "common.hpp"
+
+#include <coro/coro.hpp>
+#include <coro/executors/thread_pool_executor.hpp>
+#include <coro/helpers/all.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+constexpr int FibN = 35;
+constexpr int FibCutoff = 18;
+constexpr size_t SortSize = 4'000'000;
+constexpr size_t SortCutoff = 8192;
+
+uint64_t fibSerial(int n) {
+    return n < 2 ? n : fibSerial(n - 1) + fibSerial(n - 2);
+}
+
+coro::Task<uint64_t> fibForkJoin(int n) {
+    if (n < FibCutoff) {
+        co_return fibSerial(n);
+    }
+    auto r = co_await coro::forkJoin(fibForkJoin(n - 1), fibForkJoin(n - 2));
+    co_return r[0] + r[1];
+}
+
+coro::Task<uint64_t> fibAll(int n) {
+    if (n < FibCutoff) {
+        co_return fibSerial(n);
+    }
+    std::vector<coro::Task<uint64_t>> tasks;
+    tasks.push_back(fibAll(n - 1));
+    tasks.push_back(fibAll(n - 2));
+    auto r = co_await coro::all(std::move(tasks));
+    co_return r[0] + r[1];
+}
+
+coro::Task<void> quickSort(int* begin, int* end) {
+    if (static_cast<size_t>(end - begin) < SortCutoff) {
+        std::sort(begin, end);
+        co_return;
+    }
+    int pivot = *(begin + (end - begin) / 2);
+    int* middle1 = std::partition(begin, end, [pivot](int x) { return x < pivot; });
+    int* middle2 = std::partition(middle1, end, [pivot](int x) { return !(pivot < x); });
+    co_await coro::forkJoin(quickSort(begin, middle1), quickSort(middle2, end));
+}
+
+} // namespace
+
+int main() {
+    std::printf("fib(%d) with sequential cutoff %d\n", FibN, FibCutoff);
+    const double fibBaseline = bench::measure([] { volatile uint64_t r = fibSerial(FibN); (void)r; });
+    bench::report("serial", 1, fibBaseline, fibBaseline);
+    for (size_t threads : bench::threadCounts()) {
+        auto pool = coro::ThreadPoolExecutor::create(threads);
+        double ms = bench::measure([&] { pool->syncWait(fibForkJoin(FibN)); });
+        bench::report("forkJoin", threads, ms, fibBaseline);
+        ms = bench::measure([&] { pool->syncWait(fibAll(FibN)); });
+        bench::report("all", threads, ms, fibBaseline);
+    }
+
+    std::printf("\nquicksort of %zu integers with sequential cutoff %zu\n", SortSize, SortCutoff);
+    std::vector<int> input(SortSize);
+    std::mt19937 random {42};
+    std::generate(input.begin(), input.end(), [&random] { return static_cast<int>(random()); });
+    auto data = input;
+    const double sortBaseline = bench::measure([&] {
+        data = input;
+        std::sort(data.begin(), data.end());
+    });
+    bench::report("std::sort", 1, sortBaseline, sortBaseline);
+    for (size_t threads : bench::threadCounts()) {
+        auto pool = coro::ThreadPoolExecutor::create(threads);
+        double ms = bench::measure([&] {
+            data = input;
+            pool->syncWait(quickSort(data.data(), data.data() + data.size()));
+        });
+        bench::report("forkJoin quicksort", threads, ms, sortBaseline);
+        if (!std::is_sorted(data.begin(), data.end())) {
+            std::printf("quicksort produced unsorted output\n");
+            return 1;
+        }
+    }
+    return 0;
+}
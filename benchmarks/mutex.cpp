@@ -0,0 +1,52 @@
+#include "common.hpp"
+
+#include <coro/coro.hpp>
+#include <coro/executors/thread_pool_executor.hpp>
+#include <coro/helpers/all.hpp>
+#include <coro/sync/mutex.hpp>
+
+namespace {
+
+constexpr size_t Tasks = 64;
+constexpr size_t Iterations = 20'000;
+
+coro::Task<void> increment(coro::Mutex& mutex, uint64_t& counter) {
+    for (size_t i = 0; i < Iterations; ++i) {
+        auto lock = co_await mutex;
+        ++counter;
+    }
+}
+
+coro::Task<void> contend(coro::Mutex& mutex, uint64_t& counter) {
+    std::vector<coro::Task<void>> tasks;
+    for (size_t i = 0; i < Tasks; ++i) {
+        tasks.push_back(increment(mutex, counter));
+    }
+    co_await coro::all(std::move(tasks));
+}
+
+} // namespace
+
+int main() {
+    std::printf("%zu tasks incrementing shared counter %zu times each\n", Tasks, Iterations);
+    for (size_t threads : bench::threadCounts()) {
+        auto pool = coro::ThreadPoolExecutor::create(threads);
+        double fifo = 0;
+        for (auto mode : {coro::Mutex::Mode::Fifo, coro::Mutex::Mode::Barging}) {
+            uint64_t counter = 0;
+            double ms = bench::measure([&] {
+                counter = 0;
+                coro::Mutex mutex {mode};
+                pool->syncWait(contend(mutex, counter));
+            });
+            if (counter != Tasks * Iterations) {
+                std::printf("lost increments\n");
+                return 1;
+            }
+            const bool isFifo = mode == coro::Mutex::Mode::Fifo;
+            fifo = isFifo ? ms : fifo;
+            bench::report(isFifo ? "fifo" : "barging", threads, ms, fifo);
+        }
+    }
+    return 0;
+}
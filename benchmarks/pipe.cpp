@@ -0,0 +1,67 @@
+#include "common.hpp"
+
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sync/pipe.hpp>
+#include <coro/sync/ring_pipe.hpp>
+
+#include <cstdlib>
+
+namespace {
+
+constexpr int Messages = 1'000'000;
+constexpr size_t Capacity = 1024;
+
+template <typename Pipe>
+coro::Task<void> produce(Pipe& pipe) {
+    for (int i = 0; i < Messages; ++i) {
+        co_await pipe.write(i);
+    }
+}
+
+template <typename Pipe>
+coro::Task<int64_t> consume(Pipe& pipe) {
+    int64_t sum = 0;
+    for (int i = 0; i < Messages; ++i) {
+        sum += co_await pipe.read();
+    }
+    co_return sum;
+}
+
+/// Passes the messages from the producer executor to the consumer one, returns false if some of them were lost.
+template <typename Pipe>
+bool hop(Pipe& pipe) {
+    auto producer = coro::SerialExecutor::create();
+    auto consumer = coro::SerialExecutor::create();
+    auto producing = producer->future(produce(pipe));
+    const int64_t sum = consumer->syncWait(consume(pipe));
+    producing.get();
+    return sum == int64_t {Messages} * (Messages - 1) / 2;
+}
+
+template <typename Pipe, typename... Args>
+double run(const char* name, double baseline, Args... args) {
+    bool ok = true;
+    double ms = bench::measure([&] {
+        Pipe pipe {args...};
+        ok = ok && hop(pipe);
+    });
+    if (!ok) {
+        std::printf("%s lost messages\n", name);
+        std::exit(1);
+    }
+    bench::report(name, 2, ms, baseline > 0 ? baseline : ms);
+    std::printf("%-32s throughput: %.1f M messages/s\n", "", Messages / ms / 1000);
+    return ms;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%d messages between two serial executors, capacity %zu\n", Messages, Capacity);
+    const double baseline = run<coro::Pipe<int>>("pipe unbounded", 0);
+    run<coro::Pipe<int>>("pipe bounded", baseline, Capacity);
+    run<coro::SpscPipe<int>>("spsc ring pipe", baseline, Capacity);
+    run<coro::MpmcPipe<int>>("mpmc ring pipe", baseline, Capacity);
+    return 0;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "handle.hpp"
+#include "result.hpp"
+#include "traits.hpp"
 #include "../detail/utils.hpp"
 
 #include <utility>
@@ -98,12 +100,26 @@ struct Awaitable {
     }
 
     Return await_resume() {
-        // eagerly destroy completed task at the end of the scope
-        detail::AtExit exit {[this]() noexcept { _task.reset(); }};
-
         // throw if stop was requested
         auto& taskPromise = _task.promise();
         taskPromise.continuation.throwIfStopped();
+        return takeResult();
+    }
+
+    /// Non throwing version of await_resume() used by coro::nothrow().
+    Result<Return> await_resume_result() {
+        if (_task.promise().continuation.promise().context->stopToken.stopRequested()) {
+            _task.reset();
+            return Result<Return>::stopped();
+        }
+        return takeResultOrError();
+    }
+
+protected:
+    /// Returns result of the completed task or rethrows its exception.
+    Return takeResult() {
+        // eagerly destroy completed task at the end of the scope
+        detail::AtExit exit {[this]() noexcept { _task.reset(); }};
 
         if constexpr (std::is_move_constructible_v<Return>) {
             return std::move(_task.promise()).value();
@@ -112,8 +128,57 @@ struct Awaitable {
         }
     }
 
-private:
+    Result<Return> takeResultOrError() {
+        detail::AtExit exit {[this]() noexcept { _task.reset(); }};
+        return std::move(_task.promise()).result();
+    }
+
+protected:
     Task _task;
 };
 
+namespace detail {
+
+/// Task paired with the caller provided storage for its result, see StoreResultAwaitable.
+/// Refers to the task instead of owning it, since gcc mishandles lifetime of non trivial temporaries in co_await.
+template <typename Task>
+struct StoreResult {
+    Task& task;
+    Task::Type* target;
+};
+
+/**
+ * Awaits the task which stores its result right into the caller provided target, so the result is not moved out of
+ * the task frame afterwards. Used by helpers collecting results of many tasks, like coro::all().
+ */
+template <typename Task>
+class StoreResultAwaitable : public Awaitable<Task> {
+public:
+    StoreResultAwaitable(StoreResult<Task> store)
+        : Awaitable<Task>(std::move(store.task)) {
+        promise().storeResultTo(store.target);
+    }
+
+    void await_resume() {
+        // eagerly destroy completed task at the end of the scope
+        detail::AtExit exit {[this]() noexcept { this->_task.reset(); }};
+        promise().continuation.throwIfStopped();
+        promise().check();
+    }
+
+private:
+    Task::promise_type& promise() {
+        return this->_task.handle().template promise<typename Task::promise_type>();
+    }
+};
+
+} // namespace detail
+
+template <typename Task>
+struct await_ready_trait<detail::StoreResult<Task>> {
+    static detail::StoreResultAwaitable<Task> await_transform(const PromiseBase&, detail::StoreResult<Task> store) {
+        return {store};
+    }
+};
+
 } // namespace coro
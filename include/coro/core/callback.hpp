@@ -1,11 +1,55 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 
 namespace coro {
 
-class Callback {
+class StopState;
+
+namespace detail {
+
+/**
+ * Intrusive node of the stop callbacks list of the StopState.
+ * The node lives inside its owner, e.g. the awaiter, so registration does not allocate, and it is unlinked from the
+ * list in O(1) when detached. Detaching the node, which is being invoked on another thread, waits till the invocation
+ * is complete, so the owner can be safely destroyed right after detach(), the same way as with std::stop_callback.
+ */
+class StopCallbackNode {
+protected:
+    using Invoke = void (*)(StopCallbackNode*) noexcept;
+
+    explicit StopCallbackNode(Invoke invoke) noexcept
+        : _invoke(invoke) {}
+
+    StopCallbackNode(const StopCallbackNode&) = delete;
+    StopCallbackNode& operator=(const StopCallbackNode&) = delete;
+
+    /// Registers the node in the given state, or invokes it right away if the stop was already requested.
+    void attach(const std::shared_ptr<StopState>& state) noexcept;
+
+    /// Unregisters the node if it is registered, should be called before the owner is destroyed.
+    void detach() noexcept;
+
+private:
+    friend class ::coro::StopState;
+    Invoke _invoke;
+    StopCallbackNode* _prev = nullptr;
+    StopCallbackNode* _next = nullptr;
+    // Set by the stop requesting thread during invocation, to find out that the node was destroyed by the callback.
+    bool* _destroyed = nullptr;
+    std::atomic<bool> _done = false;
+    std::shared_ptr<StopState> _state;
+};
+
+} // namespace detail
+
+/**
+ * Shared callback, which can be registered in the stop token or in the timed scheduler.
+ * When registered in the stop token the callback is unregistered automatically when destroyed.
+ */
+class Callback : public detail::StopCallbackNode, public std::enable_shared_from_this<Callback> {
 public:
     using Ref = std::shared_ptr<Callback>;
     using WeakRef = std::weak_ptr<Callback>;
@@ -29,12 +73,29 @@ public:
 private:
     struct Tag {};
 
+    static void invokeNode(StopCallbackNode* node) noexcept {
+        // Keep the callback alive during invocation, since the function might release the last reference to it.
+        // If the callback is already being destroyed it waits for this invocation in detach(), so just skip it.
+        auto self = static_cast<Callback*>(node)->weak_from_this().lock();
+        if (self) {
+            self->invoke();
+        }
+    }
+
 public:
     Callback(Tag, Func&& function)
-        : _function(std::move(function)) {}
+        : StopCallbackNode(&Callback::invokeNode)
+        , _function(std::move(function)) {}
+
+    ~Callback() {
+        detach();
+    }
 
 private:
     Func _function;
 };
 
 } // namespace coro
+
+// Definitions of the StopCallbackNode members
+#include "stop.hpp"
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stop.hpp"
+
+#include <chrono>
+
+namespace coro {
+
+/// Point in time by which the task should be complete, Deadline::max() stands for no deadline.
+using Deadline = std::chrono::steady_clock::time_point;
+
+/// Thrown from the built-in awaitables when the deadline of the task context has passed.
+/// Derives from StopError, so the code handling cancellation handles the exhausted budget as well.
+class DeadlineExceeded : public StopError {
+public:
+    DeadlineExceeded()
+        : StopError("Deadline of the task has been exceeded.") {}
+};
+
+namespace detail {
+
+inline bool deadlineExceeded(Deadline deadline) noexcept {
+    return deadline != Deadline::max() && Deadline::clock::now() >= deadline;
+}
+
+inline void throwIfDeadlineExceeded(Deadline deadline) {
+    if (deadlineExceeded(deadline)) {
+        throw DeadlineExceeded {};
+    }
+}
+
+/// Returns the deadline the given timeout from now, used by the timed waits like Mutex::lockFor().
+template <typename Rep, typename Period>
+Deadline deadlineAfter(std::chrono::duration<Rep, Period> timeout) {
+    return Deadline::clock::now() + std::chrono::ceil<Deadline::duration>(timeout);
+}
+
+} // namespace detail
+
+} // namespace coro
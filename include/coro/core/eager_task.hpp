@@ -0,0 +1,142 @@
+#pragma once
+
+#include "awaitable.hpp"
+#include "handle.hpp"
+#include "promise.hpp"
+#include "task.hpp"
+#include "traits.hpp"
+
+#include <coroutine>
+
+namespace coro {
+
+template <typename R>
+class EagerTask;
+
+namespace detail {
+template <typename R>
+class EagerAwaitable;
+} // namespace detail
+
+template <typename R>
+class EagerPromise : public Promise<R> {
+public:
+    using handle_t = std::coroutine_handle<EagerPromise>;
+
+public:
+    EagerTask<R> get_return_object();
+};
+
+/**
+ * Task which starts synchronously, right in the awaiting coroutine, instead of being scheduled on the executor.
+ * When co_await(ed) the task inherits executor and context of the awaiter and runs inline till its first real
+ * suspension. If it completes without suspending, which is the case for cache hits and similar fast paths, awaiting
+ * it costs nothing beyond reading the result: there is no schedule and no suspension of the awaiter. Otherwise the
+ * awaiter is suspended and resumed on completion exactly as for the regular Task.
+ * EagerTask can not start on creation, since the executor and the context are not known until it is awaited.
+ * It can be converted to the regular lazy Task, e.g. to be scheduled explicitly on some executor.
+ * ```
+ * coro::EagerTask<Data> load(Key key) {
+ *     if (auto it = cache.find(key); it != cache.end()) {
+ *         co_return it->second;
+ *     }
+ *     co_return co_await fetch(key);
+ * }
+ * ```
+ */
+template <typename R>
+class EagerTask {
+public:
+    using Type = R;
+    using promise_type = EagerPromise<R>;
+
+public:
+    EagerTask(CoroHandle handle)
+        : _handle(std::move(handle)) {}
+
+public:
+    // Move only
+    EagerTask(const EagerTask&) = delete;
+    EagerTask& operator=(const EagerTask&) = delete;
+    EagerTask(EagerTask&&) = default;
+    EagerTask& operator=(EagerTask&&) = default;
+
+public:
+    bool ready() const {
+        return _handle.promise().finished();
+    }
+
+    explicit operator bool() const {
+        return static_cast<bool>(_handle);
+    }
+
+    /// Convert to the regular lazy task, which is started only when scheduled or co_await(ed).
+    operator Task<R>() && {
+        return Task<R> {std::move(_handle)};
+    }
+
+    CoroHandle handle() const {
+        return _handle;
+    }
+
+private:
+    friend detail::EagerAwaitable<R>;
+    CoroHandle _handle;
+};
+
+template <typename R>
+EagerTask<R> EagerPromise<R>::get_return_object() {
+    return EagerTask<R>(CoroHandle::fromTypedHandle(handle_t::from_promise(*this)));
+}
+
+namespace detail {
+
+template <typename R>
+class EagerAwaitable : public Awaitable<Task<R>> {
+public:
+    EagerAwaitable(EagerTask<R>&& task, const PromiseBase& awaiting)
+        : Awaitable<Task<R>>(Task<R> {task._handle})
+        , _promise(task._handle.template promise<EagerPromise<R>>())
+        , _awaiting(awaiting) {
+        task._handle.reset();
+    }
+
+    bool await_ready() {
+        if (_promise.executor == nullptr) {
+            _promise.executor = _awaiting.executor;
+            _promise.inheritContext(_awaiting);
+            // Run inline till the first suspension. If the task is finished by then there is no need to suspend,
+            // otherwise it will resume the awaiter as usual, via the continuation set in await_suspend().
+            EagerPromise<R>::handle_t::from_promise(_promise).resume();
+        }
+        return _promise.finished();
+    }
+
+    R await_resume() {
+        // the task might have completed inline without continuation, so check the stop token of the awaiter directly
+        _awaiting.context->stopToken.throwIfStopped();
+        return this->takeResult();
+    }
+
+    Result<R> await_resume_result() {
+        if (_awaiting.context->stopToken.stopRequested()) {
+            return Result<R>::stopped();
+        }
+        return this->takeResultOrError();
+    }
+
+private:
+    EagerPromise<R>& _promise;
+    const PromiseBase& _awaiting;
+};
+
+} // namespace detail
+
+template <typename R>
+struct await_ready_trait<EagerTask<R>> {
+    static detail::EagerAwaitable<R> await_transform(const PromiseBase& promise, EagerTask<R>&& task) {
+        return {std::move(task), promise};
+    }
+};
+
+} // namespace coro
@@ -3,13 +3,19 @@
 #include "handle.hpp"
 #include "task.fwd.hpp"
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
 
 namespace coro {
 
 class Executor : public std::enable_shared_from_this<Executor> {
 public:
     using Ref = std::shared_ptr<Executor>;
+    class TaskRef;
 
     virtual ~Executor() = default;
 
@@ -41,9 +47,139 @@ public:
     /// that it is executed next.
     virtual void next(CoroHandle coro) = 0;
 
+    /// Will be called to schedule several independant handles at once, e.g. when all awaiters of some shared
+    /// result are released together. Handles should be scheduled in the given order.
+    /// Default implementation schedules them one by one, override to enqueue the whole batch with a single wake up.
+    virtual void scheduleBatch(std::span<CoroHandle> coros) {
+        for (auto& coro : coros) {
+            schedule(std::move(coro));
+        }
+    }
+
     /// Will be called to indicate that given coroutine is suspended and waiting
     /// for external event and will be scheduled in the future, by external force.
     virtual void external(CoroHandle coro) = 0;
+
+private:
+    friend class TaskRef;
+
+    void retainTask() noexcept {
+        size_t tasks = _tasks.load(std::memory_order_relaxed);
+        while (tasks > 0) {
+            if (_tasks.compare_exchange_weak(tasks, tasks + 1, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        std::scoped_lock lock {_selfMutex};
+        if (_tasks.fetch_add(1, std::memory_order_relaxed) == 0) {
+            // executors not owned by shared_ptr are kept alive by their owners
+            _self = weak_from_this().lock();
+        }
+    }
+
+    void releaseTask() noexcept {
+        size_t tasks = _tasks.load(std::memory_order_relaxed);
+        while (tasks > 1) {
+            if (_tasks.compare_exchange_weak(tasks, tasks - 1, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+        Ref self;
+        {
+            std::scoped_lock lock {_selfMutex};
+            if (_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                self = std::move(_self);
+            }
+        }
+        // the executor might be destroyed here, outside of its own mutex
+    }
+
+private:
+    // Count of the tasks bound to this executor, the executor holds a reference to itself while it is non zero.
+    std::atomic<size_t> _tasks = 0;
+    std::mutex _selfMutex;
+    Ref _self;
+};
+
+/**
+ * Reference to the executor held by the task promise, which keeps the executor alive via its intrusive count of the
+ * bound tasks instead of the shared_ptr. Only the transitions of the count from and to zero touch the shared_ptr of
+ * the executor. Awaitables of the suspended task rely on the reference held by its promise and store raw Executor*.
+ */
+class Executor::TaskRef {
+public:
+    TaskRef() = default;
+
+    TaskRef(std::nullptr_t) noexcept {}
+
+    TaskRef(Executor* executor) noexcept
+        : _executor(executor) {
+        if (_executor) {
+            _executor->retainTask();
+        }
+    }
+
+    TaskRef(const Executor::Ref& executor) noexcept
+        : TaskRef(executor.get()) {}
+
+    TaskRef(const TaskRef& other) noexcept
+        : TaskRef(other._executor) {}
+
+    TaskRef(TaskRef&& other) noexcept
+        : _executor(std::exchange(other._executor, nullptr)) {}
+
+    TaskRef& operator=(TaskRef other) noexcept {
+        std::swap(_executor, other._executor);
+        return *this;
+    }
+
+    ~TaskRef() {
+        if (_executor) {
+            _executor->releaseTask();
+        }
+    }
+
+public:
+    Executor* get() const noexcept {
+        return _executor;
+    }
+
+    Executor* operator->() const noexcept {
+        return _executor;
+    }
+
+    Executor& operator*() const noexcept {
+        return *_executor;
+    }
+
+    explicit operator bool() const noexcept {
+        return _executor != nullptr;
+    }
+
+    /// Returns shared reference to the executor, e.g. to keep it outside of the task.
+    /// Returns nullptr for the executors not owned by shared_ptr, which are kept alive by their owners.
+    Executor::Ref ref() const {
+        return _executor ? _executor->weak_from_this().lock() : nullptr;
+    }
+
+    friend bool operator==(const TaskRef& lhs, const TaskRef& rhs) noexcept {
+        return lhs._executor == rhs._executor;
+    }
+
+    friend bool operator==(const TaskRef& lhs, const Executor* rhs) noexcept {
+        return lhs._executor == rhs;
+    }
+
+    friend bool operator==(const TaskRef& lhs, const Executor::Ref& rhs) noexcept {
+        return lhs._executor == rhs.get();
+    }
+
+    friend bool operator==(const TaskRef& lhs, std::nullptr_t) noexcept {
+        return lhs._executor == nullptr;
+    }
+
+private:
+    Executor* _executor = nullptr;
 };
 
 } // namespace coro
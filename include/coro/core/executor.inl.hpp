@@ -9,7 +9,7 @@ template <typename R>
 Task<R> Executor::schedule(Task<R>&& task) {
     CoroHandle handle = task.handle();
     PromiseBase& p = handle.promise();
-    p.executor = shared_from_this();
+    p.executor = this;
     p.executor->schedule(std::move(handle));
     return std::move(task);
 }
@@ -18,7 +18,7 @@ template <typename R>
 Task<R> Executor::next(Task<R>&& task) {
     CoroHandle handle = task.handle();
     PromiseBase& p = handle.promise();
-    p.executor = shared_from_this();
+    p.executor = this;
     p.executor->next(std::move(handle));
     return std::move(task);
 }
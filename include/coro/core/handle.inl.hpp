@@ -87,7 +87,7 @@ inline void CoroHandle::resume() {
 }
 
 inline void CoroHandle::throwIfStopped() {
-    promise().context.stopToken.throwIfStopped();
+    promise().context->stopToken.throwIfStopped();
 }
 
 inline CoroHandle::operator bool() const {
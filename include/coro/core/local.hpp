@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace coro {
+
+namespace detail {
+
+/// Flat array of the coroutine local values indexed by the id of the LocalKey.
+class Locals {
+public:
+    static size_t allocateId() noexcept {
+        static std::atomic<size_t> nextId = 0;
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const void* get(size_t id) const noexcept {
+        return id < _slots.size() ? _slots[id].get() : nullptr;
+    }
+
+    void set(size_t id, std::shared_ptr<const void> value) {
+        if (id >= _slots.size()) {
+            _slots.resize(id + 1);
+        }
+        _slots[id] = std::move(value);
+    }
+
+    bool empty() const noexcept {
+        return _slots.empty();
+    }
+
+    /// Sets all the values present in the other locals on top of these ones.
+    void overlay(const Locals& other) {
+        if (other._slots.size() > _slots.size()) {
+            _slots.resize(other._slots.size());
+        }
+        for (size_t id = 0; id < other._slots.size(); ++id) {
+            if (other._slots[id]) {
+                _slots[id] = other._slots[id];
+            }
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<const void>> _slots;
+};
+
+} // namespace detail
+
+/**
+ * Typed key of the coroutine local value, which is stored in the task context and inherited by the children.
+ * Every key gets its own slot in the flat array of the context, so lookup is a single bounds checked index, and
+ * missing value is reported as nullptr without allocating. Keys are expected to be long living, e.g. globals, since
+ * their ids are never reused.
+ * ```
+ * inline const coro::LocalKey<std::string> requestId;
+ * co_await handle(request).setLocal(requestId, request.id);
+ * // somewhere down the task tree
+ * const std::string* id = co_await coro::local(requestId);
+ * ```
+ */
+template <typename T>
+class LocalKey {
+public:
+    using Type = T;
+
+    LocalKey() noexcept
+        : _id(detail::Locals::allocateId()) {}
+
+    LocalKey(const LocalKey&) = delete;
+    LocalKey& operator=(const LocalKey&) = delete;
+
+    size_t id() const noexcept {
+        return _id;
+    }
+
+private:
+    size_t _id;
+};
+
+} // namespace coro
@@ -4,18 +4,18 @@
 #include "awaitable.hpp"
 #include "executor.hpp"
 #include "promise_base.hpp"
+#include "result.hpp"
 
 #include "traits.hpp"
 
+#include <concepts>
 #include <coroutine>
 #include <exception>
+#include <optional>
+#include <type_traits>
 
 namespace coro {
 
-class UninitializedValue : public std::runtime_error {
-    using std::runtime_error::runtime_error;
-};
-
 template <typename R>
 class Promise : public PromiseBase {
 public:
@@ -25,40 +25,104 @@ public:
 public:
     Task<R> get_return_object();
 
-    void return_value(R r) {
-        emplace_value(std::move(r));
+    /// Forwards co_return(ed) expression directly to the result storage, so the value is constructed in place
+    /// rather than copied into the argument first.
+    template <typename U = R>
+        requires std::constructible_from<R, U&&>
+    void return_value(U&& value) {
+        if constexpr (std::is_assignable_v<R&, U&&>) {
+            if (_target) {
+                *_target = std::forward<U>(value);
+                _valueState = PromiseBase::ValueState::Value;
+                return;
+            }
+        }
+        emplace_value(std::forward<U>(value));
     }
 
 public:
-    void emplace_value(R&& value) {
-        _value = std::move(value);
+    /// Constructs the result in place from the given arguments.
+    template <typename... Args>
+    void emplace_value(Args&&... args) {
+        if (_target) {
+            *_target = R(std::forward<Args>(args)...);
+        } else {
+            _value.emplace(std::forward<Args>(args)...);
+        }
         _valueState = PromiseBase::ValueState::Value;
     }
 
+    /// Makes the task store its result right into the given caller provided object instead of own storage.
+    /// Should be called before the task is started, the target should outlive the task.
+    void storeResultTo(R* target) {
+        _target = target;
+    }
+
     const R& value() const& {
-        switch (_valueState) {
-        case PromiseBase::ValueState::Uninitialized:
-            throw UninitializedValue("Value is not initialized.");
-        case PromiseBase::ValueState::Exception:
-            std::rethrow_exception(_exception);
-        case PromiseBase::ValueState::Value:
-            return _value;
-        }
+        throwIfNoValue();
+        return _target ? *_target : *_value;
     }
 
     R&& value() && {
-        switch (_valueState) {
-        case PromiseBase::ValueState::Uninitialized:
-            throw UninitializedValue("Value is not initialized.");
-        case PromiseBase::ValueState::Exception:
-            std::rethrow_exception(_exception);
-        case PromiseBase::ValueState::Value:
-            return std::move(_value);
+        throwIfNoValue();
+        return std::move(_target ? *_target : *_value);
+    }
+
+    /// Returns the result without throwing, either the value or the stored exception.
+    Result<R> result() && {
+        if (auto error = noValueError()) {
+            return Result<R> {std::move(error)};
         }
+        return Result<R> {std::move(*this).value()};
+    }
+
+    /// Throws if the task did not produce a value, used when the value itself was already stored to the target.
+    void check() const {
+        throwIfNoValue();
     }
 
 private:
-    R _value;
+    std::optional<R> _value;
+    R* _target = nullptr;
+};
+
+template <typename R>
+class Promise<R&> : public PromiseBase {
+public:
+    using handle_t = std::coroutine_handle<Promise>;
+    using return_t = R&;
+
+public:
+    Task<R&> get_return_object();
+
+    void return_value(R& value) {
+        emplace_value(value);
+    }
+
+public:
+    void emplace_value(R& value) {
+        _value = &value;
+        _valueState = PromiseBase::ValueState::Value;
+    }
+
+    R& value() const {
+        throwIfNoValue();
+        return *_value;
+    }
+
+    Result<R&> result() && {
+        if (auto error = noValueError()) {
+            return Result<R&> {std::move(error)};
+        }
+        return Result<R&> {*_value};
+    }
+
+    void check() const {
+        throwIfNoValue();
+    }
+
+private:
+    R* _value = nullptr;
 };
 
 template <>
@@ -80,14 +144,18 @@ public:
     }
 
     void value() {
-        switch (_valueState) {
-        case PromiseBase::ValueState::Uninitialized:
-            throw UninitializedValue("Value is not initialized.");
-        case PromiseBase::ValueState::Exception:
-            std::rethrow_exception(_exception);
-        case PromiseBase::ValueState::Value:
-            return;
+        throwIfNoValue();
+    }
+
+    Result<void> result() && {
+        if (auto error = noValueError()) {
+            return Result<void> {std::move(error)};
         }
+        return Result<void> {};
+    }
+
+    void check() const {
+        throwIfNoValue();
     }
 };
 
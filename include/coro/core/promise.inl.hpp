@@ -16,6 +16,11 @@ Task<R> Promise<R>::get_return_object() {
     return Task<R>(CoroHandle::fromTypedHandle(handle_t::from_promise(*this)));
 }
 
+template <typename R>
+Task<R&> Promise<R&>::get_return_object() {
+    return Task<R&>(CoroHandle::fromTypedHandle(handle_t::from_promise(*this)));
+}
+
 inline Task<void> Promise<void>::get_return_object() {
     return Task<void>(CoroHandle::fromTypedHandle(handle_t::from_promise(*this)));
 }
@@ -1,16 +1,26 @@
 #pragma once
 
 #include "awaitable.hpp"
+#include "deadline.hpp"
 #include "executor.hpp"
 #include "handle.hpp"
+#include "local.hpp"
 #include "stop.hpp"
 #include "task.fwd.hpp"
 #include "traits.hpp"
 
+#include <atomic>
+#include <exception>
 #include <mutex>
+#include <stdexcept>
+#include <utility>
 
 namespace coro {
 
+class UninitializedValue : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
 struct UserData {
     using Ref = std::shared_ptr<UserData>;
 
@@ -22,6 +32,105 @@ inline UserData::~UserData() {}
 struct TaskContext {
     StopToken stopToken = nullptr;
     UserData::Ref userData;
+    /// When set, the awaited child task which has its own stop token keeps it instead of inheriting the parent one,
+    /// and the token is linked to the parent token. So the child can be stopped on its own, and is stopped along with
+    /// the parent. The option is inherited by the children as well.
+    bool linkStopTokens = false;
+    /// Deadline enforced by the built-in awaitables, which fail with DeadlineExceeded once it has passed.
+    /// Inherited by the children, which can only tighten it.
+    Deadline deadline = Deadline::max();
+    /// Coroutine local values, see LocalKey. Values set on the child are kept on top of the inherited ones.
+    detail::Locals locals;
+
+    template <typename T>
+    const T* local(const LocalKey<T>& key) const noexcept {
+        return static_cast<const T*>(locals.get(key.id()));
+    }
+
+    template <typename T, typename U>
+    void setLocal(const LocalKey<T>& key, U&& value) {
+        locals.set(key.id(), std::make_shared<const T>(std::forward<U>(value)));
+    }
+};
+
+/**
+ * Copy on write reference to the immutable TaskContext, shared by the task and all the children inheriting it.
+ * Inheriting the context costs a single atomic increment regardless of its contents, and the default empty context
+ * is not allocated at all. Modifying the context via mutate() copies it first, if it is shared with other tasks.
+ */
+class ContextRef {
+    struct Shared {
+        TaskContext context;
+        std::atomic<uint32_t> refs = 1;
+    };
+
+public:
+    ContextRef() = default;
+
+    explicit ContextRef(const TaskContext& context)
+        : _shared(new Shared {context}) {}
+
+    ContextRef(const ContextRef& other) noexcept
+        : _shared(other._shared) {
+        if (_shared) {
+            _shared->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ContextRef(ContextRef&& other) noexcept
+        : _shared(std::exchange(other._shared, nullptr)) {}
+
+    ContextRef& operator=(ContextRef other) noexcept {
+        std::swap(_shared, other._shared);
+        return *this;
+    }
+
+    ~ContextRef() {
+        reset();
+    }
+
+public:
+    const TaskContext& operator*() const noexcept {
+        return _shared ? _shared->context : empty();
+    }
+
+    const TaskContext* operator->() const noexcept {
+        return &operator*();
+    }
+
+    /// Returns whether the context differs from the default one, i.e. it is allocated.
+    explicit operator bool() const noexcept {
+        return _shared != nullptr;
+    }
+
+    /// Returns modifiable context, which is copied first if it is shared, or allocated if it is empty.
+    TaskContext& mutate() {
+        if (!_shared) {
+            _shared = new Shared {};
+        } else if (_shared->refs.load(std::memory_order_acquire) != 1) {
+            auto* copy = new Shared {_shared->context};
+            reset();
+            _shared = copy;
+        }
+        return _shared->context;
+    }
+
+    /// Resets to the default empty context.
+    void reset() noexcept {
+        if (_shared && _shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete _shared;
+        }
+        _shared = nullptr;
+    }
+
+private:
+    static const TaskContext& empty() noexcept {
+        static const TaskContext context;
+        return context;
+    }
+
+private:
+    Shared* _shared = nullptr;
 };
 
 class PromiseBase {
@@ -37,13 +146,13 @@ private:
     std::atomic<size_t> _useCount = 0;
 
 public:
-    Executor::Ref executor;
-    TaskContext context;
+    Executor::TaskRef executor;
+    ContextRef context;
     CoroHandle continuation = nullptr;
 
 protected:
     std::exception_ptr _exception;
-    ValueState _valueState;
+    ValueState _valueState = ValueState::Uninitialized;
 
 private:
     mutable std::mutex _mutex;
@@ -56,6 +165,26 @@ public:
         _valueState = ValueState::Exception;
     }
 
+protected:
+    /// Throws if there is no value, either rethrows the stored exception or throws UninitializedValue.
+    void throwIfNoValue() const {
+        if (_valueState == ValueState::Exception) {
+            std::rethrow_exception(_exception);
+        } else if (_valueState == ValueState::Uninitialized) [[unlikely]] {
+            throw UninitializedValue("Value is not initialized.");
+        }
+    }
+
+    /// Non throwing version of throwIfNoValue(), returns the error to report if there is no value.
+    std::exception_ptr noValueError() const {
+        if (_valueState == ValueState::Exception) {
+            return _exception;
+        } else if (_valueState == ValueState::Uninitialized) [[unlikely]] {
+            return std::make_exception_ptr(UninitializedValue("Value is not initialized."));
+        }
+        return nullptr;
+    }
+
 public:
     PromiseBase() = default;
 
@@ -100,11 +229,16 @@ public:
 
 public:
     void set_continuation(CoroHandle&& cont) {
-        std::scoped_lock lock {_mutex};
-        continuation = std::move(cont);
-        if (_finished) {
-            schedule_continuation();
+        {
+            std::scoped_lock lock {_mutex};
+            continuation = std::move(cont);
+            if (!_finished) {
+                return;
+            }
         }
+        // Schedule outside of the lock, since on multi threaded executors the continuation might be resumed and
+        // destroy this promise before the lock is released.
+        schedule_continuation();
     }
 
     bool finished() const {
@@ -117,20 +251,49 @@ public:
     }
 
     void inheritContext(const PromiseBase& from) {
-        if (_inheritContext) [[likely]] {
+        if (!_inheritContext) [[unlikely]] {
+            return;
+        }
+        const TaskContext& own = *context;
+        const TaskContext& parent = *from.context;
+        const bool keepStopToken = parent.linkStopTokens && own.stopToken && own.stopToken != parent.stopToken;
+        const bool keepDeadline = own.deadline < parent.deadline;
+        const bool keepLocals = !own.locals.empty();
+        if (!keepStopToken && !keepDeadline && !keepLocals) [[likely]] {
+            // share the parent context as is
             context = from.context;
+            return;
+        }
+        // the child has set some fields on its own, which are merged into the copy of the parent context
+        const ContextRef ownContext = std::exchange(context, from.context);
+        TaskContext& merged = context.mutate();
+        if (keepStopToken) {
+            ownContext->stopToken.linkTo(merged.stopToken);
+            merged.stopToken = ownContext->stopToken;
+        }
+        if (keepDeadline) {
+            merged.deadline = ownContext->deadline;
+        }
+        if (keepLocals) {
+            merged.locals.overlay(ownContext->locals);
         }
     }
 
 private:
     void on_finished() {
-        std::scoped_lock lock {_mutex};
+        {
+            std::scoped_lock lock {_mutex};
+            _finished = true;
+            if (!continuation) {
+                return;
+            }
+        }
         schedule_continuation();
-        _finished = true;
     }
 
     void schedule_continuation() {
         if (continuation) {
+            // keep executor alive while scheduling, since resumed continuation can release the last reference to it
             auto continuationExecutor = continuation.promise().executor;
             if (continuationExecutor == executor) {
                 continuationExecutor->next(continuation);
@@ -142,14 +305,15 @@ private:
 };
 
 /// Helper to easily access to the current executor within the coroutine.
-/// const Executor::Ref& executor = co_await coro::currentExecutor;
+/// Executor::Ref executor = co_await coro::currentExecutor;
+/// Results in nullptr for the executors not owned by shared_ptr, use the raw executor of the promise to access them.
 struct ExecutorAwaitable {};
 inline ExecutorAwaitable currentExecutor;
 
 template <>
 struct await_ready_trait<ExecutorAwaitable> {
     static decltype(auto) await_transform(const PromiseBase& promise, ExecutorAwaitable) {
-        return ReadyAwaitable<const Executor::Ref&> {promise.executor};
+        return ReadyAwaitable<Executor::Ref> {promise.executor.ref()};
     }
 };
 
@@ -161,7 +325,19 @@ inline StopTokenAwaitable currentStopToken;
 template <>
 struct await_ready_trait<StopTokenAwaitable> {
     static decltype(auto) await_transform(const PromiseBase& promise, StopTokenAwaitable) {
-        return ReadyAwaitable<const StopToken&> {promise.context.stopToken};
+        return ReadyAwaitable<const StopToken&> {promise.context->stopToken};
+    }
+};
+
+/// Helper to easily access to the deadline of the current task
+/// coro::Deadline deadline = co_await coro::currentDeadline;
+struct DeadlineAwaitable {};
+inline DeadlineAwaitable currentDeadline;
+
+template <>
+struct await_ready_trait<DeadlineAwaitable> {
+    static decltype(auto) await_transform(const PromiseBase& promise, DeadlineAwaitable) {
+        return ReadyAwaitable<Deadline> {promise.context->deadline};
     }
 };
 
@@ -173,7 +349,26 @@ inline UserDataAwaitable currentUserData;
 template <>
 struct await_ready_trait<UserDataAwaitable> {
     static decltype(auto) await_transform(const PromiseBase& promise, UserDataAwaitable) {
-        return ReadyAwaitable<const UserData::Ref&> {promise.context.userData};
+        return ReadyAwaitable<const UserData::Ref&> {promise.context->userData};
+    }
+};
+
+/// Helper to access the coroutine local value, returns nullptr if it is not set.
+/// const std::string* id = co_await coro::local(requestId);
+template <typename T>
+struct LocalAwaitable {
+    size_t id;
+};
+
+template <typename T>
+LocalAwaitable<T> local(const LocalKey<T>& key) {
+    return LocalAwaitable<T> {key.id()};
+}
+
+template <typename T>
+struct await_ready_trait<LocalAwaitable<T>> {
+    static decltype(auto) await_transform(const PromiseBase& promise, LocalAwaitable<T> awaitable) {
+        return ReadyAwaitable<const T*> {static_cast<const T*>(promise.context->locals.get(awaitable.id))};
     }
 };
 
@@ -185,7 +380,7 @@ inline TaskContextAwaitable currentContext;
 template <>
 struct await_ready_trait<TaskContextAwaitable> {
     static decltype(auto) await_transform(PromiseBase& promise, TaskContextAwaitable) {
-        return ReadyAwaitable<const TaskContext&> {promise.context};
+        return ReadyAwaitable<const TaskContext&> {*promise.context};
     }
 };
 
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "stop.hpp"
+
+#include <exception>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace coro {
+
+/**
+ * Outcome of the asynchronous operation reported as a value rather than as an exception.
+ * Holds either the result value, the error exception_ptr, or the stopped state when the operation was cancelled via
+ * stop token. The stopped state does not carry any exception, so cancellation reported via Result does not construct
+ * or rethrow StopError unless value() is called on it.
+ * Usually obtained from `co_await coro::nothrow(awaitable)`, but can also be used as a task result type, in which case
+ * coro::nothrow() unwraps it to avoid Result<Result<T>>.
+ */
+template <typename T>
+class Result {
+    using Stored = std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+    struct Stopped {};
+
+public:
+    using Type = T;
+
+    /// Default constructed result holds value initialized T, the same way as std::expected does.
+    Result() = default;
+
+    Result(T value)
+        : _data(std::in_place_index<0>, std::forward<T>(value)) {}
+
+    Result(std::exception_ptr error)
+        : _data(std::in_place_index<1>, std::move(error)) {}
+
+    static Result stopped() {
+        return Result {Stopped {}};
+    }
+
+public:
+    bool hasValue() const noexcept {
+        return _data.index() == 0;
+    }
+
+    bool hasError() const noexcept {
+        return _data.index() == 1;
+    }
+
+    bool isStopped() const noexcept {
+        return _data.index() == 2;
+    }
+
+    explicit operator bool() const noexcept {
+        return hasValue();
+    }
+
+    /// Returns the stored error, or nullptr if there is none.
+    std::exception_ptr error() const noexcept {
+        return hasError() ? std::get<1>(_data) : nullptr;
+    }
+
+    /// Returns the stored value, rethrows the stored error or throws StopError if the result was stopped.
+    std::add_lvalue_reference_t<T> value() & {
+        check();
+        return std::get<0>(_data);
+    }
+
+    std::add_lvalue_reference_t<const T> value() const& {
+        check();
+        return std::get<0>(_data);
+    }
+
+    T value() && {
+        check();
+        if constexpr (std::is_reference_v<T>) {
+            return std::get<0>(_data).get();
+        } else {
+            return std::move(std::get<0>(_data));
+        }
+    }
+
+private:
+    Result(Stopped stopped)
+        : _data(std::in_place_index<2>, stopped) {}
+
+    void check() const {
+        if (hasError()) {
+            std::rethrow_exception(std::get<1>(_data));
+        } else if (isStopped()) {
+            throw StopError {};
+        }
+    }
+
+private:
+    std::variant<Stored, std::exception_ptr, Stopped> _data;
+};
+
+template <>
+class Result<void> {
+    struct Stopped {};
+
+public:
+    using Type = void;
+
+    Result() = default;
+
+    Result(std::exception_ptr error)
+        : _data(std::in_place_index<1>, std::move(error)) {}
+
+    static Result stopped() {
+        return Result {Stopped {}};
+    }
+
+public:
+    bool hasValue() const noexcept {
+        return _data.index() == 0;
+    }
+
+    bool hasError() const noexcept {
+        return _data.index() == 1;
+    }
+
+    bool isStopped() const noexcept {
+        return _data.index() == 2;
+    }
+
+    explicit operator bool() const noexcept {
+        return hasValue();
+    }
+
+    std::exception_ptr error() const noexcept {
+        return hasError() ? std::get<1>(_data) : nullptr;
+    }
+
+    /// Rethrows the stored error or throws StopError if the result was stopped.
+    void value() const {
+        if (hasError()) {
+            std::rethrow_exception(std::get<1>(_data));
+        } else if (isStopped()) {
+            throw StopError {};
+        }
+    }
+
+private:
+    Result(Stopped stopped)
+        : _data(std::in_place_index<2>, stopped) {}
+
+private:
+    std::variant<std::monostate, std::exception_ptr, Stopped> _data;
+};
+
+} // namespace coro
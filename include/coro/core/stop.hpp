@@ -4,10 +4,11 @@
 
 #include <atomic>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
+#include <exception>
 #include <memory>
-#include <mutex>
-#include <vector>
+#include <stdexcept>
+#include <thread>
 
 namespace coro {
 
@@ -15,6 +16,10 @@ class StopError : std::runtime_error {
 public:
     StopError()
         : std::runtime_error("Stop was requested via stop token.") {}
+
+protected:
+    explicit StopError(const char* message)
+        : std::runtime_error(message) {}
 };
 
 class StopToken;
@@ -25,51 +30,216 @@ public:
 
 private:
     friend class StopSource;
+    friend class detail::StopCallbackNode;
     struct Tag {};
 
 public:
-    StopState(Tag, std::exception_ptr&& exception) {
-        _exception = exception ? std::move(exception) : std::make_exception_ptr(StopError {});
+    StopState(Tag, std::exception_ptr&& exception)
+        : _parentLink(this)
+        , _exception(std::move(exception)) {}
+
+    ~StopState() {
+        _parentLink.detach();
     }
 
 public:
+    /// Requests stop and invokes all registered callbacks on the calling thread, each one exactly once.
     void requestStop() noexcept {
-        std::scoped_lock lock {_mutex};
-        _stopRequested.store(true);
-        auto callbacks = std::move(_callbacks);
-        for (const auto& weakCB : callbacks) {
-            auto callback = weakCB.lock();
-            if (callback) {
-                callback->invoke();
+        lock();
+        if (_state.load(std::memory_order_relaxed) & StopRequestedBit) {
+            unlock();
+            return;
+        }
+        _state.fetch_or(StopRequestedBit, std::memory_order_release);
+        _requestingThread = std::this_thread::get_id();
+        while (auto* node = _head) {
+            _head = node->_next;
+            if (_head) {
+                _head->_prev = nullptr;
+            }
+            node->_next = nullptr;
+            _invoking = node;
+            bool destroyed = false;
+            node->_destroyed = &destroyed;
+            // Invoke without holding the lock, so the callback can register or unregister other callbacks.
+            unlock();
+            node->_invoke(node);
+            if (!destroyed) {
+                node->_destroyed = nullptr;
+                node->_done.store(true, std::memory_order_release);
+                node->_done.notify_all();
             }
+            lock();
+            _invoking = nullptr;
         }
+        unlock();
     }
 
     bool stopRequested() const noexcept {
-        return _stopRequested.load();
+        return _state.load(std::memory_order_acquire) & StopRequestedBit;
     }
 
     void addStopCallback(Callback::WeakRef&& callbackWeak) {
-        std::scoped_lock lock {_mutex};
-        if (_stopRequested) {
-            auto callbackRef = callbackWeak.lock();
-            if (callbackRef) {
-                callbackRef->invoke();
-            }
-        } else {
-            _callbacks.push_back(std::move(callbackWeak));
+        auto callback = callbackWeak.lock();
+        if (callback) {
+            callback->detach();
+            callback->attach(shared_from_this());
+        }
+    }
+
+    /**
+     * Links this state to the parent one, so the stop requested on the parent is propagated to this state as well.
+     * The link is an intrusive node embedded in the state itself, so neither linking nor propagation allocates, and
+     * requesting stop on the parent costs one invocation per directly linked child. State can have only one parent,
+     * returns false if it is already linked. Linked states must not form cycles.
+     */
+    bool link(const Ptr& parent) noexcept {
+        if (!parent || parent.get() == this) {
+            return false;
         }
+        lock();
+        if (_state.load(std::memory_order_relaxed) & LinkedBit) {
+            unlock();
+            return false;
+        }
+        _state.fetch_or(LinkedBit, std::memory_order_relaxed);
+        unlock();
+        _parentLink.attach(parent);
+        return true;
+    }
+
+    /// Detaches the state from its parent in O(1), e.g. when the linked child is finished but its state is still alive.
+    void unlink() noexcept {
+        _parentLink.detach();
+        _state.fetch_and(~LinkedBit, std::memory_order_release);
     }
 
+    /// Returns exception to be thrown on stop. The default StopError is created only when it is actually needed,
+    /// so the sources which are never thrown from do not pay for it.
     std::exception_ptr exception() const {
-        return _exception;
+        return _exception ? _exception : std::make_exception_ptr(StopError {});
+    }
+
+private:
+    /// Links the node to the list, returns false if the stop was already requested.
+    bool add(detail::StopCallbackNode* node) noexcept {
+        lock();
+        if (_state.load(std::memory_order_relaxed) & StopRequestedBit) {
+            unlock();
+            return false;
+        }
+        node->_prev = nullptr;
+        node->_next = _head;
+        if (_head) {
+            _head->_prev = node;
+        }
+        _head = node;
+        unlock();
+        return true;
+    }
+
+    /// Unlinks the node from the list, or waits for its invocation to complete if it is being invoked right now.
+    void remove(detail::StopCallbackNode* node) noexcept {
+        lock();
+        if (node->_prev || _head == node) {
+            if (node->_prev) {
+                node->_prev->_next = node->_next;
+            } else {
+                _head = node->_next;
+            }
+            if (node->_next) {
+                node->_next->_prev = node->_prev;
+            }
+            node->_prev = nullptr;
+            node->_next = nullptr;
+            unlock();
+            return;
+        }
+        const bool invoking = _invoking == node;
+        const bool invokingThread = _requestingThread == std::this_thread::get_id();
+        unlock();
+        if (invoking) {
+            if (invokingThread) {
+                // destroyed by the callback itself, let requestStop() know that the node is gone
+                if (node->_destroyed) {
+                    *node->_destroyed = true;
+                }
+            } else {
+                node->_done.wait(false, std::memory_order_acquire);
+            }
+        }
+    }
+
+    /// Callbacks list is guarded by the lock bit of the state word, which is held only for a few pointer updates.
+    /// Contended lock is spun on for a bounded number of iterations, after which the waiter is parked via
+    /// std::atomic::wait(), so the holder preempted in the middle does not burn the CPU of the other threads.
+    void lock() noexcept {
+        uint32_t state = _state.load(std::memory_order_relaxed);
+        for (uint32_t spins = 0;; ++spins) {
+            if (!(state & LockedBit)) {
+                if (_state.compare_exchange_weak(
+                        state, state | LockedBit, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            if (spins < MaxSpins) {
+                state = _state.load(std::memory_order_relaxed);
+                continue;
+            }
+            // let unlock() know that there is a parked waiter to notify
+            if (!(state & ParkedBit) &&
+                !_state.compare_exchange_weak(state, state | ParkedBit, std::memory_order_relaxed)) {
+                continue;
+            }
+            _state.wait(state | ParkedBit, std::memory_order_relaxed);
+            state = _state.load(std::memory_order_relaxed);
+        }
+    }
+
+    void unlock() noexcept {
+        if (_state.fetch_and(~(LockedBit | ParkedBit), std::memory_order_release) & ParkedBit) {
+            // all parked waiters are woken up, the ones failing to take the lock park again
+            _state.notify_all();
+        }
     }
 
 private:
-    std::atomic<bool> _stopRequested = false;
-    std::vector<Callback::WeakRef> _callbacks;
+    /// Node registered in the parent state, which requests stop on the owning child state.
+    class ParentLink : public detail::StopCallbackNode {
+    public:
+        explicit ParentLink(StopState* child) noexcept
+            : StopCallbackNode(&ParentLink::invokeNode)
+            , _child(child) {}
+
+        using StopCallbackNode::attach;
+        using StopCallbackNode::detach;
+
+    private:
+        static void invokeNode(StopCallbackNode* node) noexcept {
+            // The child being destroyed waits for this invocation in its destructor, so it is just skipped.
+            auto child = static_cast<ParentLink*>(node)->_child->weak_from_this().lock();
+            if (child) {
+                child->requestStop();
+            }
+        }
+
+    private:
+        StopState* _child;
+    };
+
+    static constexpr uint32_t StopRequestedBit = 1;
+    static constexpr uint32_t LockedBit = 2;
+    static constexpr uint32_t LinkedBit = 4;
+    static constexpr uint32_t ParkedBit = 8;
+    static constexpr uint32_t MaxSpins = 64;
+
+    std::atomic<uint32_t> _state = 0;
+    detail::StopCallbackNode* _head = nullptr;
+    detail::StopCallbackNode* _invoking = nullptr;
+    std::thread::id _requestingThread;
+    ParentLink _parentLink;
     std::exception_ptr _exception;
-    std::mutex _mutex;
 };
 
 class StopToken {
@@ -107,13 +277,13 @@ public:
     }
 
 public:
-    void addStopCallback(Callback::WeakRef callback) {
+    void addStopCallback(Callback::WeakRef callback) const {
         if (_state) {
             _state->addStopCallback(std::move(callback));
         }
     }
 
-    Callback::Ref addStopCallback(Callback::Func func) {
+    Callback::Ref addStopCallback(Callback::Func func) const {
         if (!_state) {
             return Callback::Ref {};
         }
@@ -122,6 +292,12 @@ public:
         return result;
     }
 
+    /// Links the state of this token to the parent token, see StopSource::linked().
+    /// Returns false if the state is already linked, or either of the tokens is empty.
+    bool linkTo(const StopToken& parent) const noexcept {
+        return _state && _state->link(parent._state);
+    }
+
     bool operator==(const StopToken& other) const {
         return _state == other._state;
     }
@@ -132,6 +308,8 @@ public:
 
 private:
     friend class StopSource;
+    template <typename F>
+    friend class StopCallback;
     StopToken(StopState::Ptr state)
         : _state(std::move(state)) {}
 
@@ -145,6 +323,18 @@ public:
         reset(std::move(exception));
     }
 
+    /**
+     * Creates source linked to the parent token, which is stopped either directly or when the parent is stopped.
+     * Allows building cancellation trees, where every subtree can be cancelled on its own, while cancelling the root
+     * cancels everything. The link does not keep the child alive and is detached in O(1) when the child state is
+     * destroyed or unlink() is called.
+     */
+    static StopSource linked(const StopToken& parent, std::exception_ptr exception = nullptr) {
+        StopSource source {std::move(exception)};
+        source._state->link(parent._state);
+        return source;
+    }
+
 public:
     StopToken token() const noexcept {
         return StopToken {_state};
@@ -158,8 +348,14 @@ public:
         return _state->stopRequested();
     }
 
+    /// Stops propagation of the stop requests from the parent token, if the source was linked.
+    void unlink() noexcept {
+        _state->unlink();
+    }
+
+    /// Replaces the state by a new one, which is not linked to any parent.
     void reset() {
-        _state = std::make_shared<StopState>(StopState::Tag {}, _state->exception());
+        reset(_state->_exception);
     }
 
     void reset(std::exception_ptr exception) {
@@ -170,4 +366,70 @@ private:
     StopState::Ptr _state;
 };
 
+/**
+ * Stop callback in the style of std::stop_callback, invoking given function when stop is requested via the token.
+ * The callback is registered in the constructor and unregistered in the destructor. If stop was already requested the
+ * function is invoked right in the constructor. Unlike the Callback::Ref returned by StopToken::addStopCallback(),
+ * it is stored inline, e.g. as a member of the awaiter, so neither registration nor unregistration allocates.
+ * If the function is being invoked on another thread, the destructor waits till it returns.
+ * ```
+ * coro::StopCallback callback {stopToken, [&]() { socket.cancel(); }};
+ * ```
+ */
+template <typename F>
+class StopCallback : private detail::StopCallbackNode {
+public:
+    template <typename U>
+    explicit StopCallback(const StopToken& token, U&& function)
+        : StopCallbackNode(&StopCallback::invokeNode)
+        , _function(std::forward<U>(function)) {
+        attach(token._state);
+    }
+
+    ~StopCallback() {
+        detach();
+    }
+
+    StopCallback(const StopCallback&) = delete;
+    StopCallback& operator=(const StopCallback&) = delete;
+
+private:
+    static void invokeNode(StopCallbackNode* node) noexcept {
+        try {
+            static_cast<StopCallback*>(node)->_function();
+        } catch (...) {
+        }
+    }
+
+private:
+    F _function;
+};
+
+template <typename F>
+StopCallback(const StopToken&, F) -> StopCallback<F>;
+
+namespace detail {
+
+inline void StopCallbackNode::attach(const std::shared_ptr<StopState>& state) noexcept {
+    if (!state) {
+        return;
+    }
+    // state should be set before the node is linked, since it can be invoked and detached right away
+    _state = state;
+    if (!state->add(this)) {
+        _state.reset();
+        _done.store(true, std::memory_order_relaxed);
+        _invoke(this);
+    }
+}
+
+inline void StopCallbackNode::detach() noexcept {
+    if (_state) {
+        _state->remove(this);
+        _state.reset();
+    }
+}
+
+} // namespace detail
+
 } // namespace coro
@@ -47,43 +47,80 @@ public:
 
 public:
     const StopToken& stopToken() const {
-        return promise().context.stopToken;
+        return promise().context->stopToken;
     }
 
     void setStopToken(StopToken token) & {
-        auto& p = promise();
-        p.context.stopToken = std::move(token);
+        promise().context.mutate().stopToken = std::move(token);
     }
 
     Task&& setStopToken(StopToken token) && {
-        auto& p = promise();
-        p.context.stopToken = std::move(token);
+        promise().context.mutate().stopToken = std::move(token);
+        return std::move(*this);
+    }
+
+    Deadline deadline() const {
+        return promise().context->deadline;
+    }
+
+    void setDeadline(Deadline deadline) & {
+        promise().context.mutate().deadline = deadline;
+    }
+
+    Task&& setDeadline(Deadline deadline) && {
+        promise().context.mutate().deadline = deadline;
         return std::move(*this);
     }
 
     const UserData::Ref& userData() const {
-        return promise().context.userData;
+        return promise().context->userData;
     }
 
     void setUserData(UserData::Ref userData) & {
-        promise().context.userData = std::move(userData);
+        promise().context.mutate().userData = std::move(userData);
     }
 
     Task&& setUserData(UserData::Ref userData) && {
-        promise().context.userData = std::move(userData);
+        promise().context.mutate().userData = std::move(userData);
+        return std::move(*this);
+    }
+
+    template <typename T>
+    const T* local(const LocalKey<T>& key) const {
+        return promise().context->local(key);
+    }
+
+    template <typename T, typename U>
+    void setLocal(const LocalKey<T>& key, U&& value) & {
+        promise().context.mutate().setLocal(key, std::forward<U>(value));
+    }
+
+    template <typename T, typename U>
+    Task&& setLocal(const LocalKey<T>& key, U&& value) && {
+        promise().context.mutate().setLocal(key, std::forward<U>(value));
         return std::move(*this);
     }
 
     const TaskContext& context() const {
-        return promise().context;
+        return *promise().context;
     }
 
     void setContext(const TaskContext& context) & {
-        promise().context = context;
+        promise().context = ContextRef {context};
     }
 
     Task&& setContext(const TaskContext& context) && {
-        promise().context = context;
+        promise().context = ContextRef {context};
+        return std::move(*this);
+    }
+
+    /// Shares the given context with the task without copying it.
+    void setContext(ContextRef context) & {
+        promise().context = std::move(context);
+    }
+
+    Task&& setContext(ContextRef context) && {
+        promise().context = std::move(context);
         return std::move(*this);
     }
 
@@ -4,12 +4,17 @@
 #include "core/promise_base.hpp"
 #include "core/promise.hpp"
 #include "core/task.hpp"
+#include "core/eager_task.hpp"
 #include "core/promise.inl.hpp"
 #include "core/handle.inl.hpp"
 #include "core/executor.hpp"
+#include "core/deadline.hpp"
 #include "core/stop.hpp"
 #include "core/executor.hpp"
 #include "core/executor.inl.hpp"
 
 #include "helpers/all.hpp"
+#include "helpers/nothrow.hpp"
+#include "helpers/resume_on.hpp"
+#include "helpers/shared_task.hpp"
 #include "helpers/task_or_value.hpp"
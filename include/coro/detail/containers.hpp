@@ -83,6 +83,10 @@ public:
         return _queue.empty();
     }
 
+    size_t size() const {
+        return _queue.size();
+    }
+
     T& front() {
         return _queue.front();
     }
@@ -154,4 +158,117 @@ private:
     mutable std::mutex _mutex;
 };
 
+template <typename T>
+class IntrusiveList;
+
+/**
+ * Node of the IntrusiveList, should be publicly inherited by the listed type.
+ */
+template <typename T>
+class IntrusiveListNode {
+public:
+    bool linked() const noexcept {
+        return _linked;
+    }
+
+private:
+    friend IntrusiveList<T>;
+    T* _prev = nullptr;
+    T* _next = nullptr;
+    bool _linked = false;
+};
+
+/**
+ * Doubly linked list of the nodes living inside their owners, e.g. suspended awaiters.
+ * Does not allocate and removes any node in O(1), is not thread safe.
+ */
+template <typename T>
+class IntrusiveList {
+    using Node = IntrusiveListNode<T>;
+
+public:
+    IntrusiveList() = default;
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    void pushBack(T* element) noexcept {
+        Node* node = element;
+        node->_prev = _tail;
+        node->_next = nullptr;
+        node->_linked = true;
+        if (_tail) {
+            static_cast<Node*>(_tail)->_next = element;
+        } else {
+            _head = element;
+        }
+        _tail = element;
+    }
+
+    void pushFront(T* element) noexcept {
+        Node* node = element;
+        node->_prev = nullptr;
+        node->_next = _head;
+        node->_linked = true;
+        if (_head) {
+            static_cast<Node*>(_head)->_prev = element;
+        } else {
+            _tail = element;
+        }
+        _head = element;
+    }
+
+    /// Moves all nodes of the other list to the back of this one in O(1).
+    void append(IntrusiveList& other) noexcept {
+        if (other.empty()) {
+            return;
+        }
+        if (_tail) {
+            static_cast<Node*>(_tail)->_next = other._head;
+            static_cast<Node*>(other._head)->_prev = _tail;
+        } else {
+            _head = other._head;
+        }
+        _tail = other._tail;
+        other._head = nullptr;
+        other._tail = nullptr;
+    }
+
+    T* popFront() noexcept {
+        T* element = _head;
+        if (element) {
+            remove(element);
+        }
+        return element;
+    }
+
+    void remove(T* element) noexcept {
+        Node* node = element;
+        if (node->_prev) {
+            static_cast<Node*>(node->_prev)->_next = node->_next;
+        } else {
+            _head = node->_next;
+        }
+        if (node->_next) {
+            static_cast<Node*>(node->_next)->_prev = node->_prev;
+        } else {
+            _tail = node->_prev;
+        }
+        node->_prev = nullptr;
+        node->_next = nullptr;
+        node->_linked = false;
+    }
+
+    T* front() const noexcept {
+        return _head;
+    }
+
+    bool empty() const noexcept {
+        return _head == nullptr;
+    }
+
+private:
+    T* _head = nullptr;
+    T* _tail = nullptr;
+};
+
 } // namespace coro::detail
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../core/callback.hpp"
+#include "../core/deadline.hpp"
+
+#ifndef CORO_EMSCRIPTEN
+#include "timed_scheduler.hpp"
+#endif
+
+#include <memory>
+#include <mutex>
+
+namespace coro::detail {
+
+/**
+ * Invokes the given cancellation when the deadline expires, the cancellation is responsible for resuming the awaiter.
+ * disarm() removes the pending timeout, or waits for the invocation running on the timer thread, so the cancellation
+ * may refer to the awaiter which is destroyed right after disarm().
+ * In emscripten environment there is no timer thread, so the deadline is only checked when the awaitable resumes.
+ */
+class CancelTimer {
+public:
+    CancelTimer() = default;
+    CancelTimer(const CancelTimer&) = delete;
+    CancelTimer& operator=(const CancelTimer&) = delete;
+
+    ~CancelTimer() {
+        disarm();
+    }
+
+    template <typename F>
+    void arm(Deadline deadline, F cancel) {
+        if (deadline == Deadline::max()) {
+            return;
+        }
+#ifndef CORO_EMSCRIPTEN
+        auto guard = std::make_shared<Guard>();
+        _callback = Callback::create([guard, cancel = std::move(cancel)]() {
+            std::scoped_lock lock {guard->mutex};
+            if (guard->armed) {
+                cancel();
+            }
+        });
+        _guard = std::move(guard);
+        _timer = TimedScheduler::instance().timeout(deadline, _callback);
+#else
+        (void)cancel;
+#endif
+    }
+
+    void disarm() noexcept {
+#ifndef CORO_EMSCRIPTEN
+        // the timeout removed before firing is never invoked, otherwise wait for the invocation if it is running
+        if (_guard && !TimedScheduler::instance().cancel(_timer)) {
+            std::scoped_lock lock {_guard->mutex};
+            _guard->armed = false;
+        }
+#endif
+        _guard.reset();
+        _callback.reset();
+    }
+
+private:
+    struct Guard {
+        std::mutex mutex;
+        bool armed = true;
+    };
+
+    std::shared_ptr<Guard> _guard;
+    Callback::Ref _callback;
+#ifndef CORO_EMSCRIPTEN
+    TimedScheduler::TimerId _timer;
+#endif
+};
+
+} // namespace coro::detail
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../core/executor.hpp"
+#include "../core/handle.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/traits.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+
+namespace coro::detail {
+
+/**
+ * Lock free join point of the child tasks running in parallel to the awaiting parent coroutine.
+ * Counts down arrivals of the children and the awaiting parent itself, and resumes the parent exactly once when the
+ * last of them arrives. Unlike the Latch it does not need any shared state or mutex, so it can live right in the
+ * parent coroutine frame, which is guaranteed to outlive all the children.
+ */
+class JoinCounter {
+public:
+    JoinCounter(size_t children)
+        : _remaining(children + 1) {}
+
+    /// Marks arrival of the child running on the given executor.
+    /// Nothing from the parent frame should be touched after the call, since the parent might be already resumed.
+    void arrive(const Executor* current) {
+        if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // keep executor alive while scheduling, since resumed parent can release the last reference to it
+            Executor::TaskRef executor = _executor;
+            if (executor == current) {
+                executor->next(std::move(_continuation));
+            } else {
+                executor->schedule(std::move(_continuation));
+            }
+        }
+    }
+
+    /// Stores the first error reported by the children, the rest are ignored.
+    void fail(std::exception_ptr eptr) {
+        bool expected = false;
+        if (_failed.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
+            _exception = std::move(eptr);
+        }
+    }
+
+    /// Marks arrival of the parent, which will be resumed when all children arrive.
+    /// Returns false if all children have already arrived, so there is no need to suspend the parent at all.
+    template <typename Promise>
+    bool wait(std::coroutine_handle<Promise> parent) noexcept {
+        _continuation = CoroHandle::fromTypedHandle(parent);
+        _executor = parent.promise().executor.get();
+        return _remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    /// Called from the resumed parent, rethrows the first error reported by the children if any.
+    void resume() {
+        _continuation.reset();
+        if (_exception) {
+            std::rethrow_exception(_exception);
+        }
+    }
+
+private:
+    std::atomic<size_t> _remaining;
+    std::atomic<bool> _failed = false;
+    std::exception_ptr _exception;
+    Executor* _executor = nullptr;
+    CoroHandle _continuation;
+};
+
+class JoinAwaitable {
+public:
+    JoinAwaitable(JoinCounter& join)
+        : _join(join) {}
+
+    bool await_ready() noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> parent) noexcept {
+        return _join.wait(parent);
+    }
+
+    void await_resume() {
+        _join.resume();
+    }
+
+private:
+    JoinCounter& _join;
+};
+
+/**
+ * Final suspension point of the child task, which marks its arrival at the join point.
+ * Arrival happens from await_suspend(), when the child is already suspended, so the parent resumed on another thread
+ * can safely destroy the child frame, while this thread is still returning from the arrival. Hence the child is never
+ * resumed and does not reach its final_suspend(), it is destroyed by its owner.
+ */
+class ArriveAwaitable {
+public:
+    ArriveAwaitable(JoinCounter& join)
+        : _join(join) {}
+
+    bool await_ready() noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> child) noexcept {
+        // this awaitable lives in the child frame, so it should not be touched after the arrival
+        JoinCounter& join = _join;
+        join.arrive(child.promise().executor.get());
+    }
+
+    [[noreturn]] void await_resume() noexcept {
+        // should not reach here
+        std::abort();
+    }
+
+private:
+    JoinCounter& _join;
+};
+
+} // namespace coro::detail
+
+namespace coro {
+
+template <>
+struct await_ready_trait<detail::ArriveAwaitable> {
+    static detail::ArriveAwaitable await_transform(const PromiseBase&, detail::ArriveAwaitable awaitable) {
+        return awaitable;
+    }
+};
+
+template <>
+struct await_ready_trait<detail::JoinCounter> {
+    static detail::JoinAwaitable await_transform(const PromiseBase&, detail::JoinCounter& join) {
+        return {join};
+    }
+};
+
+} // namespace coro
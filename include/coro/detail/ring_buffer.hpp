@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace coro::detail {
+
+/// Assumed size of the cache line, used to keep the indices modified by different threads apart.
+inline constexpr size_t CacheLineSize = 64;
+
+/**
+ * Uninitialized storage of a single ring buffer element.
+ */
+template <typename T>
+class RingSlot {
+public:
+    void construct(T&& data) {
+        new (_storage) T(std::move(data));
+    }
+
+    T take() {
+        T* data = std::launder(reinterpret_cast<T*>(_storage));
+        T result = std::move(*data);
+        data->~T();
+        return result;
+    }
+
+private:
+    alignas(T) unsigned char _storage[sizeof(T)];
+};
+
+/// Capacity of the ring rounded up to the power of two, at least two elements.
+inline size_t ringCapacity(size_t capacity) {
+    return std::bit_ceil(std::max<size_t>(capacity, 2));
+}
+
+/**
+ * Lock free bounded ring buffer for a single producer and a single consumer.
+ * Each side keeps its own index and the cached copy of the other side index on its own cache line, so the shared
+ * indices are read only when the cached copy says the ring is full or empty.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : _mask(ringCapacity(capacity) - 1)
+        , _slots(new RingSlot<T>[_mask + 1]) {}
+
+    ~SpscRing() {
+        while (tryPop()) {
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const noexcept {
+        return _mask + 1;
+    }
+
+    /// Moves the data into the ring, returns false without consuming the data if the ring is full.
+    bool tryPush(T& data) {
+        const size_t tail = _producer.tail.load(std::memory_order_relaxed);
+        if (tail - _producer.cachedHead > _mask) {
+            _producer.cachedHead = _consumer.head.load(std::memory_order_acquire);
+            if (tail - _producer.cachedHead > _mask) {
+                return false;
+            }
+        }
+        _slots[tail & _mask].construct(std::move(data));
+        _producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> tryPop() {
+        const size_t head = _consumer.head.load(std::memory_order_relaxed);
+        if (head == _consumer.cachedTail) {
+            _consumer.cachedTail = _producer.tail.load(std::memory_order_acquire);
+            if (head == _consumer.cachedTail) {
+                return std::nullopt;
+            }
+        }
+        std::optional<T> data {_slots[head & _mask].take()};
+        _consumer.head.store(head + 1, std::memory_order_release);
+        return data;
+    }
+
+private:
+    struct alignas(CacheLineSize) Producer {
+        std::atomic<size_t> tail = 0;
+        size_t cachedHead = 0;
+    };
+
+    struct alignas(CacheLineSize) Consumer {
+        std::atomic<size_t> head = 0;
+        size_t cachedTail = 0;
+    };
+
+    const size_t _mask;
+    std::unique_ptr<RingSlot<T>[]> _slots;
+    Producer _producer;
+    Consumer _consumer;
+};
+
+/**
+ * Lock free bounded ring buffer for multiple producers and multiple consumers.
+ * Every slot carries the sequence number telling whether it is ready for the producer or for the consumer of the
+ * given lap, so both sides claim the slots with a single compare and swap of their own index.
+ */
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : _mask(ringCapacity(capacity) - 1)
+        , _slots(new Slot[_mask + 1]) {
+        for (size_t i = 0; i <= _mask; ++i) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcRing() {
+        while (tryPop()) {
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    size_t capacity() const noexcept {
+        return _mask + 1;
+    }
+
+    /// Moves the data into the ring, returns false without consuming the data if the ring is full.
+    bool tryPush(T& data) {
+        size_t position = _tail.value.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = _slots[position & _mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence - position);
+            if (diff == 0) {
+                if (_tail.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.data.construct(std::move(data));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // the slot of the previous lap is not consumed yet
+                return false;
+            } else {
+                position = _tail.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> tryPop() {
+        size_t position = _head.value.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = _slots[position & _mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence - (position + 1));
+            if (diff == 0) {
+                if (_head.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    std::optional<T> data {slot.data.take()};
+                    slot.sequence.store(position + _mask + 1, std::memory_order_release);
+                    return data;
+                }
+            } else if (diff < 0) {
+                // the slot of this lap is not produced yet
+                return std::nullopt;
+            } else {
+                position = _head.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        RingSlot<T> data;
+    };
+
+    struct alignas(CacheLineSize) Index {
+        std::atomic<size_t> value = 0;
+    };
+
+    const size_t _mask;
+    std::unique_ptr<Slot[]> _slots;
+    Index _tail;
+    Index _head;
+};
+
+} // namespace coro::detail
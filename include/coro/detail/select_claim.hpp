@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../core/executor.hpp"
+#include "../core/handle.hpp"
+
+#include <atomic>
+
+namespace coro::detail {
+
+/**
+ * Shared state of the sources awaited together by coro::select(), making sure exactly one of them completes it.
+ * The source which wins the claim stores its result and releases the claim, while the awaiter releases it once all
+ * sources are registered. The last of the two resumes the awaiter, so it is never resumed in the middle of the
+ * registration, even if one of the already registered sources completes concurrently.
+ */
+class SelectClaim {
+public:
+    /// Returns true for the single caller which completes the select.
+    bool claim() noexcept {
+        return !_claimed.exchange(true, std::memory_order_acq_rel);
+    }
+
+    bool claimed() const noexcept {
+        return _claimed.load(std::memory_order_acquire);
+    }
+
+    /// Returns true if the caller is the last one and should resume the awaiter.
+    bool release() noexcept {
+        return _pending.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    /// Releases the claim and schedules the awaiter if it is already registered.
+    void complete() {
+        if (release()) {
+            executor->schedule(continuation);
+        }
+    }
+
+public:
+    Executor* executor = nullptr;
+    CoroHandle continuation;
+
+private:
+    std::atomic<bool> _claimed = false;
+    std::atomic<int> _pending = 2;
+};
+
+} // namespace coro::detail
@@ -1,113 +1,82 @@
 #pragma once
 
 #include "../core/promise.hpp"
+#include "timed_scheduler.hpp"
 
-#include <condition_variable>
+#include <algorithm>
+#include <chrono>
 #include <coroutine>
-#include <map>
-#include <mutex>
-#include <thread>
 
 namespace coro {
 
 namespace detail {
 
-class TimedScheduler {
-public:
-    using Clock = std::chrono::steady_clock;
-    using TimePoint = Clock::time_point;
-
-    TimedScheduler() {
-        _thread = std::thread([this] {
-            while (_loop) {
-                std::unique_lock lock {_mutex};
-                if (_timeouts.empty()) {
-                    _cv.wait(lock, [this] { return !_loop || !_timeouts.empty(); });
-                }
-                if (!_loop) return;
-                while (true) {
-                    auto timePoint = _timeouts.begin()->first;
-                    auto status = _cv.wait_until(lock, timePoint);
-                    if (!_loop) return;
-                    if (status == std::cv_status::timeout) {
-                        break;
-                    }
-                }
-                cleanupFiredTimers();
-            }
-        });
-    }
-
-    ~TimedScheduler() {
-        _loop = false;
-        _cv.notify_one();
-        _thread.join();
-    }
-
-    void timeout(std::chrono::milliseconds time, Callback::WeakRef callback) {
-        auto now = Clock::now();
-        now += time;
-        std::scoped_lock lock {_mutex};
-        _timeouts[now].push_back(std::move(callback));
-        _cv.notify_one();
-    }
-
-private:
-    void cleanupFiredTimers() {
-        auto now = Clock::now();
-        auto it = _timeouts.begin();
-        for (; it != _timeouts.end() && now >= it->first; ++it) {
-            for (auto& weakCB : it->second) {
-                auto callback = weakCB.lock();
-                if (callback) {
-                    callback->invoke();
-                }
-            }
-        }
-        _timeouts.erase(_timeouts.begin(), it);
-    }
-
-private:
-    std::thread _thread;
-    std::map<TimePoint, std::vector<Callback::WeakRef>> _timeouts;
-    std::condition_variable _cv;
-    std::mutex _mutex;
-    std::atomic<bool> _loop = true;
-};
-
 class SleepAwaitable {
 public:
     SleepAwaitable(uint32_t sleep)
         : _sleep(sleep) {}
 
+    /// Duration of the sleep in milliseconds.
+    uint32_t duration() const noexcept {
+        return _sleep;
+    }
+
     bool await_ready() noexcept {
         return false;
     }
 
     template <typename Promise>
-    void await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
-        static detail::TimedScheduler scheduler;
+    bool await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
         _continuation = CoroHandle::fromTypedHandle(continuation);
         auto& promise = _continuation.promise();
+        const Deadline deadline = promise.context->deadline;
+        if (detail::deadlineExceeded(deadline)) {
+            // fail fast without scheduling the timer
+            return false;
+        }
         promise.executor->external(_continuation);
         _callback = Callback::create([handle = _continuation]() {
             auto& promise = handle.promise();
             promise.executor->schedule(std::move(handle));
         });
-        scheduler.timeout(std::chrono::milliseconds {_sleep}, _callback);
+        // sleep past the deadline wakes up at the deadline to fail
+        auto wakeUp = std::min<Deadline>(TimedScheduler::Clock::now() + std::chrono::milliseconds {_sleep}, deadline);
+        _timer = TimedScheduler::instance().timeout(wakeUp, _callback);
+        return true;
     }
 
     void await_resume() {
-        detail::AtExit exit {[this]() noexcept {
-            _callback.reset();
-            _continuation.reset();
-        }};
+        detail::AtExit exit {[this]() noexcept { release(); }};
         _continuation.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_continuation.promise().context->deadline);
+    }
+
+    Result<void> await_resume_result() {
+        detail::AtExit exit {[this]() noexcept { release(); }};
+        const TaskContext& context = *_continuation.promise().context;
+        if (context.stopToken.stopRequested()) {
+            return Result<void>::stopped();
+        }
+        if (detail::deadlineExceeded(context.deadline)) {
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    void release() noexcept {
+        // sleep is woken up before its timeout only by the stop request, the timeout is not kept till it expires then
+        if (_callback && _continuation.promise().context->stopToken.stopRequested()) {
+            TimedScheduler::instance().cancel(_timer);
+        }
+        _callback.reset();
+        _continuation.reset();
     }
 
 private:
     CoroHandle _continuation;
     Callback::Ref _callback;
+    TimedScheduler::TimerId _timer;
     uint32_t _sleep;
 };
 
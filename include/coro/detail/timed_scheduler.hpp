@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../core/callback.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coro::detail {
+
+class TimedScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /// Key of the scheduled timeout, which can be used to cancel it before it fires.
+    /// Timeouts with the same time point fire in the order they were scheduled.
+    struct TimerId {
+        TimePoint timePoint;
+        uint64_t sequence = 0;
+
+        auto operator<=>(const TimerId&) const = default;
+    };
+
+    TimedScheduler() {
+        _thread = std::thread([this] {
+            std::vector<Callback::WeakRef> fired;
+            std::unique_lock lock {_mutex};
+            while (_loop) {
+                if (_timeouts.empty()) {
+                    _cv.wait(lock, [this] { return !_loop || !_timeouts.empty(); });
+                    continue;
+                }
+                // earliest timeout might be cancelled or the earlier one added while waiting, so it is re-evaluated
+                const TimePoint timePoint = _timeouts.begin()->first.timePoint;
+                if (Clock::now() < timePoint) {
+                    _cv.wait_until(lock, timePoint);
+                    continue;
+                }
+                takeFiredTimers(fired);
+                // Invoke without holding the lock, so the callbacks do not block scheduling and cancellation of the
+                // other timeouts, e.g. while they are waiting for the locks of the primitives.
+                lock.unlock();
+                for (auto& weakCB : fired) {
+                    auto callback = weakCB.lock();
+                    if (callback) {
+                        callback->invoke();
+                    }
+                }
+                fired.clear();
+                lock.lock();
+            }
+        });
+    }
+
+    ~TimedScheduler() {
+        {
+            std::scoped_lock lock {_mutex};
+            _loop = false;
+        }
+        _cv.notify_one();
+        _thread.join();
+    }
+
+    /// Shared scheduler serving sleeps and deadlines of all the tasks.
+    static TimedScheduler& instance() {
+        static TimedScheduler scheduler;
+        return scheduler;
+    }
+
+    TimerId timeout(std::chrono::milliseconds time, Callback::WeakRef callback) {
+        return timeout(Clock::now() + time, std::move(callback));
+    }
+
+    TimerId timeout(TimePoint timePoint, Callback::WeakRef callback) {
+        std::scoped_lock lock {_mutex};
+        const TimerId id {timePoint, ++_sequence};
+        const bool earliest = _timeouts.empty() || id < _timeouts.begin()->first;
+        _timeouts.emplace(id, std::move(callback));
+        if (earliest) {
+            _cv.notify_one();
+        }
+        return id;
+    }
+
+    /// Removes the timeout in O(log n), so the waits satisfied before their deadline do not keep their entries till
+    /// it passes. Returns false if the timeout has already fired or is being fired right now.
+    bool cancel(const TimerId& id) {
+        std::scoped_lock lock {_mutex};
+        return _timeouts.erase(id) != 0;
+    }
+
+    /// Returns the number of the scheduled timeouts, which have not fired yet.
+    size_t pending() {
+        std::scoped_lock lock {_mutex};
+        return _timeouts.size();
+    }
+
+private:
+    void takeFiredTimers(std::vector<Callback::WeakRef>& fired) {
+        auto now = Clock::now();
+        auto it = _timeouts.begin();
+        for (; it != _timeouts.end() && now >= it->first.timePoint; ++it) {
+            fired.push_back(std::move(it->second));
+        }
+        _timeouts.erase(_timeouts.begin(), it);
+    }
+
+private:
+    std::thread _thread;
+    std::map<TimerId, Callback::WeakRef> _timeouts;
+    uint64_t _sequence = 0;
+    std::condition_variable _cv;
+    std::mutex _mutex;
+    bool _loop = true;
+};
+
+} // namespace coro::detail
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/stop.hpp"
+#include "deadline_timer.hpp"
+
+#include <optional>
+
+namespace coro::detail {
+
+/**
+ * Wakes the queued awaiter up early, when its task is stopped or the deadline expires.
+ * Both the stop callback and the timer call `awaiter->cancel()`, which should remove the awaiter from the queue of
+ * the primitive and resume it only if it was still there. This way the awaiter is resumed exactly once, by whatever
+ * comes first: the event, the stop request or the deadline.
+ * Should be armed before the awaiter is queued, without holding the primitive lock, since the stop callback is invoked
+ * right away if the stop was already requested. disarm() waits for the concurrently running cancellation, so the
+ * awaiter can be safely destroyed after it.
+ */
+template <typename Awaiter>
+class WaitCanceller {
+public:
+    void arm(Awaiter* awaiter, const StopToken& stopToken, Deadline deadline) {
+        _stopCallback.emplace(stopToken, Cancel {awaiter});
+        _timer.arm(deadline, Cancel {awaiter});
+    }
+
+    void disarm() noexcept {
+        _stopCallback.reset();
+        _timer.disarm();
+    }
+
+private:
+    struct Cancel {
+        Awaiter* awaiter;
+
+        void operator()() const {
+            awaiter->cancel();
+        }
+    };
+
+    std::optional<StopCallback<Cancel>> _stopCallback;
+    CancelTimer _timer;
+};
+
+} // namespace coro::detail
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../core/executor.hpp"
+#include "../core/handle.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace coro::detail {
+
+/**
+ * Collects suspended coroutines which should be resumed together, grouped by their executors.
+ * Used by primitives releasing many awaiters at once, so each executor gets the whole group with a single
+ * Executor::scheduleBatch() call instead of a wake up per awaiter.
+ */
+class WakeList {
+public:
+    void push(Executor* executor, CoroHandle handle) {
+        for (auto& group : _groups) {
+            if (group.executor == executor) {
+                group.handles.push_back(std::move(handle));
+                return;
+            }
+        }
+        _groups.push_back(Group {executor, {std::move(handle)}});
+    }
+
+    bool empty() const {
+        return _groups.empty();
+    }
+
+    /// Schedules all collected coroutines, should be called without holding any locks of the releasing primitive.
+    void schedule() {
+        auto groups = std::move(_groups);
+        for (auto& group : groups) {
+            group.executor->scheduleBatch(group.handles);
+        }
+    }
+
+private:
+    struct Group {
+        // keeps executor alive while scheduling, since resumed coroutines can release the last reference to it
+        Executor::TaskRef executor;
+        std::vector<CoroHandle> handles;
+    };
+
+    std::vector<Group> _groups;
+};
+
+} // namespace coro::detail
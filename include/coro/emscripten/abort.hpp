@@ -96,7 +96,7 @@ inline AbortTokenAwaitable abortSignal(int32_t timeout = -1) {
 template <>
 struct await_ready_trait<AbortTokenAwaitable> {
     static decltype(auto) await_transform(const PromiseBase& promise, const AbortTokenAwaitable& awaitable) {
-        return ReadyAwaitable {AbortToken {promise.context.stopToken, awaitable.timeout}};
+        return ReadyAwaitable {AbortToken {promise.context->stopToken, awaitable.timeout}};
     }
 };
 
@@ -34,8 +34,8 @@ private:
 struct ValAwaitable {
     ValAwaitable(emscripten::val&& val, const PromiseBase& promise)
         : _promise(std::move(val))
-        , _executor(std::move(promise.executor))
-        , _stopToken(promise.context.stopToken) {}
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken) {}
 
     ValAwaitable& operator co_await() {
         auto controllerHandle = detail::_coro_lib_await_promise(_promise.as_handle(), this);
@@ -86,7 +86,7 @@ private:
     emscripten::val _promise;
     emscripten::val _controller;
     emscripten::val _result;
-    coro::Executor::Ref _executor = nullptr;
+    coro::Executor* _executor = nullptr;
     StopToken _stopToken;
     CoroHandle _continuation;
     bool _ready = false;
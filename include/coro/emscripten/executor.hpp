@@ -161,7 +161,7 @@ private:
             auto& promise = handle.promise();
             auto callback = Callback::create([handle]() mutable { handle.promise().executor->schedule(handle); });
             externals.emplace(std::move(handle), callback);
-            promise.context.stopToken.addStopCallback(callback);
+            promise.context->stopToken.addStopCallback(callback);
         }
 
         void resetEpoch() {
@@ -17,7 +17,7 @@ public:
     CancelableSleepHelper(emscripten::val sleep, const PromiseBase& promise)
         : ValAwaitable(sleep["promise"], promise)
         , _sleep(sleep)
-        , _token(promise.context.stopToken) {}
+        , _token(promise.context->stopToken) {}
 
     CancelableSleepHelper& operator co_await() {
         ValAwaitable::operator co_await();
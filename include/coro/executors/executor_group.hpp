@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../core/executor.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace coro {
+
+/**
+ * Fixed set of executors used to spread independent work over several threads, see coro::parallelFor().
+ * The group does not own any threads by itself, it only keeps strong references to the executors it was created with,
+ * so it can be cheaply copied and passed around by value.
+ * ```
+ * auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(std::max(1u, std::thread::hardware_concurrency()));
+ * co_await coro::parallelFor(group, size_t {0}, records.size(), size_t {0}, [&](size_t i) { hash(records[i]); });
+ * ```
+ */
+class ExecutorGroup {
+public:
+    ExecutorGroup(std::vector<Executor::Ref> executors)
+        : _executors(std::move(executors)) {}
+
+    /// Create group of @p count executors of type E, each created via E::create().
+    template <typename E>
+    static ExecutorGroup create(size_t count) {
+        std::vector<Executor::Ref> executors;
+        executors.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            executors.push_back(E::create());
+        }
+        return ExecutorGroup {std::move(executors)};
+    }
+
+public:
+    size_t size() const {
+        return _executors.size();
+    }
+
+    bool empty() const {
+        return _executors.empty();
+    }
+
+    const Executor::Ref& operator[](size_t idx) const {
+        return _executors[idx];
+    }
+
+private:
+    std::vector<Executor::Ref> _executors;
+};
+
+} // namespace coro
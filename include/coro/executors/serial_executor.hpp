@@ -81,6 +81,10 @@ protected:
         _state->next(std::move(coro));
     }
 
+    void scheduleBatch(std::span<CoroHandle> coros) override {
+        _state->scheduleBatch(coros);
+    }
+
     void external(CoroHandle coro) override {
         _state->external(std::move(coro));
     }
@@ -126,6 +130,17 @@ private:
             cv.notify_one();
         }
 
+        void scheduleBatch(std::span<CoroHandle> handles) {
+            {
+                std::scoped_lock lock {mutex};
+                for (auto& handle : handles) {
+                    externals.erase(handle);
+                    tasks.pushFront(std::move(handle));
+                }
+            }
+            cv.notify_one();
+        }
+
         void external(CoroHandle&& handle) {
             auto& promise = handle.promise();
             auto callback = Callback::create(
@@ -138,7 +153,7 @@ private:
             // which in case will try to skip execution and schedule continuation of the handle.
             // So we release mutex before the call to give the schedule a chance.
             // Might be a better idea to replace the mutex with recursive_mutex.
-            promise.context.stopToken.addStopCallback(callback);
+            promise.context->stopToken.addStopCallback(callback);
         }
 
         void executorDestroyed() {
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "../coro.hpp"
+#include "../detail/containers.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coro {
+
+/**
+ * Multi threaded executor running scheduled tasks on a fixed pool of worker threads with work stealing.
+ * Each worker has its own task queue. Handles scheduled via next() from a worker thread are pushed to the hot end of
+ * that worker's queue, so they are executed right away by the same thread, while idle workers steal from the cold
+ * end of the other queues. This makes fork-join patterns like coro::forkJoin() scale with the count of workers.
+ * Handles scheduled from outside of the pool are distributed between workers in a round robin manner.
+ * This executor API is thread safe and can be used concurrently from different threads.
+ * The lifetime of each executor is prolonged by tasks scheduled on it, the same way as for the SerialExecutor.
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+    using Ref = std::shared_ptr<ThreadPoolExecutor>;
+
+    static Ref create(size_t threads = std::thread::hardware_concurrency()) {
+        return std::make_shared<ThreadPoolExecutor>(Tag {}, std::max<size_t>(threads, 1));
+    }
+
+public:
+    // See comments in the base Executor class
+    using Executor::next;
+    using Executor::schedule;
+
+    /**
+     * Schedule given task and return std::future, which will be satisfied when task is complete,
+     * either with result value of the task or with an exception if there was an error.
+     */
+    template <typename R>
+    std::future<R> future(Task<R>&& task) {
+        std::promise<R> promise;
+        std::future<R> future = promise.get_future();
+        task.handle().promise().enableContextInheritance(false);
+        Task<void> wrapper = [](Task<R> task, std::promise<R> promise) -> Task<void> {
+            try {
+                if constexpr (std::is_same_v<R, void>) {
+                    co_await std::move(task);
+                    promise.set_value();
+                } else {
+                    promise.set_value(co_await std::move(task));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }(std::move(task), std::move(promise));
+        Executor::schedule(std::move(wrapper));
+        return future;
+    }
+
+    /// Schedule given task and synchronously wait for its completion.
+    /// Returns value returned by task or throws exception if any
+    template <typename R>
+    R syncWait(Task<R>&& task) {
+        std::future<R> f = future(std::move(task));
+        return f.get();
+    }
+
+    /// Returns count of the worker threads.
+    size_t size() const {
+        return _state->workers.size();
+    }
+
+protected:
+    void schedule(CoroHandle coro) override {
+        _state->schedule(std::move(coro));
+    }
+
+    void next(CoroHandle coro) override {
+        _state->next(std::move(coro));
+    }
+
+    void scheduleBatch(std::span<CoroHandle> coros) override {
+        _state->scheduleBatch(coros);
+    }
+
+    void external(CoroHandle coro) override {
+        _state->external(std::move(coro));
+    }
+
+protected:
+    struct Tag {};
+
+public:
+    ThreadPoolExecutor(Tag, size_t threads) {
+        _state = std::make_shared<RunState>(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            std::thread([state = _state, i]() { ThreadPoolExecutor::runScheduled(state, i); }).detach();
+        }
+    }
+
+    ~ThreadPoolExecutor() {
+        _state->executorDestroyed();
+    }
+
+private:
+    struct Worker {
+        detail::Deque<CoroHandle> tasks;
+        std::mutex mutex;
+
+        void push(CoroHandle&& handle, bool hot) {
+            std::scoped_lock lock {mutex};
+            if (hot) {
+                tasks.pushBack(std::move(handle));
+            } else {
+                tasks.pushFront(std::move(handle));
+            }
+        }
+
+        /// Pop from the hot end, by the owning worker thread.
+        std::optional<CoroHandle> pop() {
+            std::scoped_lock lock {mutex};
+            return tasks.popBack();
+        }
+
+        /// Pop from the cold end, by the other idle workers.
+        std::optional<CoroHandle> steal() {
+            std::scoped_lock lock {mutex};
+            return tasks.popFront();
+        }
+    };
+
+    struct RunState {
+        using Ref = std::shared_ptr<RunState>;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::map<CoroHandle, Callback::Ref> externals;
+        std::mutex externalsMutex;
+        std::atomic<size_t> pending = 0;
+        std::atomic<size_t> sleeping = 0;
+        std::atomic<size_t> nextWorker = 0;
+        std::condition_variable cv;
+        std::mutex mutex;
+        bool finished = false;
+
+        RunState(size_t threads) {
+            for (size_t i = 0; i < threads; ++i) {
+                workers.push_back(std::make_unique<Worker>());
+            }
+        }
+
+        void schedule(CoroHandle&& handle) {
+            push(std::move(handle), false);
+        }
+
+        void next(CoroHandle&& handle) {
+            push(std::move(handle), true);
+        }
+
+        void push(CoroHandle&& handle, bool hot) {
+            {
+                std::scoped_lock lock {externalsMutex};
+                externals.erase(handle);
+            }
+            size_t idx = current == this ? currentIndex : NoWorker;
+            if (idx == NoWorker) {
+                // foreign threads always push to the cold end, so the tasks in flight of the worker go first
+                idx = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+                hot = false;
+            }
+            workers[idx]->push(std::move(handle), hot);
+            pending.fetch_add(1);
+            if (sleeping.load() > 0) {
+                {
+                    std::scoped_lock lock {mutex};
+                }
+                cv.notify_one();
+            }
+        }
+
+        void scheduleBatch(std::span<CoroHandle> handles) {
+            {
+                std::scoped_lock lock {externalsMutex};
+                for (auto& handle : handles) {
+                    externals.erase(handle);
+                }
+            }
+            // the whole batch goes to the cold end of a single queue, idle workers will spread it by stealing
+            size_t idx = current == this ? currentIndex : nextWorker.fetch_add(1, std::memory_order_relaxed);
+            Worker& worker = *workers[idx % workers.size()];
+            {
+                std::scoped_lock lock {worker.mutex};
+                for (auto& handle : handles) {
+                    worker.tasks.pushFront(std::move(handle));
+                }
+            }
+            pending.fetch_add(handles.size());
+            if (sleeping.load() > 0) {
+                {
+                    std::scoped_lock lock {mutex};
+                }
+                cv.notify_all();
+            }
+        }
+
+        std::optional<CoroHandle> take(size_t idx) {
+            auto task = workers[idx]->pop();
+            for (size_t i = 1; !task && i < workers.size(); ++i) {
+                task = workers[(idx + i) % workers.size()]->steal();
+            }
+            if (task) {
+                pending.fetch_sub(1);
+            }
+            return task;
+        }
+
+        void external(CoroHandle&& handle) {
+            auto& promise = handle.promise();
+            auto callback = Callback::create(
+                [handle = handle]() mutable { handle.promise().executor->schedule(std::move(handle)); });
+            {
+                std::scoped_lock lock {externalsMutex};
+                externals.emplace(std::move(handle), callback);
+            }
+            promise.context->stopToken.addStopCallback(callback);
+        }
+
+        void executorDestroyed() {
+            {
+                std::scoped_lock lock {mutex};
+                finished = true;
+            }
+            cv.notify_all();
+        }
+
+        static constexpr size_t NoWorker = std::numeric_limits<size_t>::max();
+        // Pool and index of the worker running on the current thread, used to push next() handles to its own queue.
+        static thread_local inline const RunState* current = nullptr;
+        static thread_local inline size_t currentIndex = NoWorker;
+    };
+
+    static void runScheduled(RunState::Ref state, size_t idx) {
+        // Runs in a separate thread for each worker
+        RunState::current = state.get();
+        RunState::currentIndex = idx;
+        while (true) {
+            auto task = state->take(idx);
+            if (!task) {
+                std::unique_lock lock {state->mutex};
+                state->sleeping.fetch_add(1);
+                state->cv.wait(lock, [&state] { return state->pending.load() > 0 || state->finished; });
+                state->sleeping.fetch_sub(1);
+                if (state->finished) {
+                    break;
+                }
+                continue;
+            }
+            // this can happen during cancellation, when coroutine waiting for external event
+            // is cancelled and the external event is fired at the same time.
+            if (task->promise().finished()) [[unlikely]] {
+                continue;
+            }
+            task->resume();
+        }
+    }
+
+private:
+    RunState::Ref _state;
+};
+
+} // namespace coro
@@ -2,6 +2,7 @@
 
 #include "../core/promise.hpp"
 #include "../core/task.hpp"
+#include "../detail/join.hpp"
 #include "../sync/latch.hpp"
 
 #include <any>
@@ -14,7 +15,10 @@ namespace detail {
 template <typename R, typename T>
 Task<void> runAndNotify(Task<T> task, Latch latch, std::exception_ptr& eptr, R* result) {
     try {
-        if constexpr (!std::is_same_v<T, void>) {
+        if constexpr (std::is_same_v<R, T> && !std::is_void_v<T>) {
+            // the task writes its result right into the results storage
+            co_await StoreResult<Task<T>> {task, result};
+        } else if constexpr (!std::is_same_v<T, void>) {
             *result = co_await std::move(task);
         } else {
             co_await std::move(task);
@@ -27,25 +31,91 @@ Task<void> runAndNotify(Task<T> task, Latch latch, std::exception_ptr& eptr, R*
     latch.count_down();
 }
 
+template <typename R, typename T>
+Task<void> runAndJoin(Task<T> task, JoinCounter& join, R* result) {
+    try {
+        if constexpr (std::is_same_v<R, T> && !std::is_void_v<T>) {
+            co_await StoreResult<Task<T>> {task, result};
+        } else if constexpr (!std::is_same_v<T, void>) {
+            *result = co_await std::move(task);
+        } else {
+            co_await std::move(task);
+        }
+    } catch (...) {
+        join.fail(std::current_exception());
+    }
+    // the child never resumes after arrival and is destroyed by its owner, which might be the resumed parent
+    co_await ArriveAwaitable {join};
+}
+
+/**
+ * Forks given child tasks from the awaiting coroutine and suspends it till all of them are joined.
+ * All children except the first one are pushed to the current executor via next(), so on a work stealing executor
+ * they are exposed for idle workers to steal, while the first child is resumed inline on the current thread right
+ * away via symmetric transfer, without going through the executor queue at all.
+ */
+class ForkAwaitable {
+public:
+    ForkAwaitable(JoinCounter& join, std::vector<Task<void>>& children)
+        : _join(join)
+        , _children(children) {}
+
+    bool await_ready() noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent) noexcept {
+        auto& parentPromise = parent.promise();
+        for (size_t i = 1; i < _children.size(); ++i) {
+            _children[i].setContext(parentPromise.context);
+            parentPromise.executor->next(std::move(_children[i]));
+        }
+        _children[0].setContext(parentPromise.context);
+        auto first = _children[0].handle();
+        first.promise().executor = parentPromise.executor;
+        if (!_join.wait(parent)) [[unlikely]] {
+            return parent;
+        }
+        return first.handle();
+    }
+
+    void await_resume() {
+        _join.resume();
+    }
+
+private:
+    JoinCounter& _join;
+    std::vector<Task<void>>& _children;
+};
+
 } // namespace detail
 
+template <>
+struct await_ready_trait<detail::ForkAwaitable> {
+    static detail::ForkAwaitable&& await_transform(const PromiseBase&, detail::ForkAwaitable&& awaitable) {
+        return std::move(awaitable);
+    }
+};
+
 template <typename... Args>
     requires(std::same_as<Args, void> && ...)
 Task<void> all(Task<Args>... tasks) {
     constexpr size_t count = sizeof...(tasks);
     static_assert(count > 2, "It does not make sense to use coro::all() with <2 arguments...");
     Latch latch {static_cast<std::ptrdiff_t>(count)};
-    auto executor = co_await currentExecutor;
     std::exception_ptr eptr = nullptr;
 
     PromiseBase& promise = co_await currentPromise;
+    Executor* executor = promise.executor.get();
 
     (executor->next(detail::runAndNotify<void>(std::move(tasks), latch, eptr, nullptr).setContext(promise.context)),
      ...);
 
-    // Reset stop token before awaiting for the latch, so we don't wake up from cancellation here when child tasks are
-    // running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
-    promise.context.stopToken.reset();
+    // Reset context before awaiting for the latch, so we don't wake up from cancellation or deadline here when child
+    // tasks are running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
+    // Children keep their own references to the shared context.
+    promise.context.reset();
     co_await latch;
     if (eptr) {
         std::rethrow_exception(eptr);
@@ -59,19 +129,20 @@ Task<std::vector<T>> all(Task<T> first, Task<Args>... rest) {
     static_assert(count > 2, "It does not make sense to use coro::all() with <2 arguments...");
     std::vector<T> results(count);
     Latch latch {static_cast<std::ptrdiff_t>(count)};
-    auto executor = co_await currentExecutor;
     std::exception_ptr eptr = nullptr;
 
     PromiseBase& promise = co_await currentPromise;
+    Executor* executor = promise.executor.get();
 
     executor->next(detail::runAndNotify(std::move(first), latch, eptr, &results[0]).setContext(promise.context));
     size_t idx = 1;
     (executor->next(detail::runAndNotify(std::move(rest), latch, eptr, &results[idx++])).setContext(promise.context),
      ...);
 
-    // Reset stop token before awaiting for the latch, so we don't wake up from cancellation here when child tasks are
-    // running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
-    promise.context.stopToken.reset();
+    // Reset context before awaiting for the latch, so we don't wake up from cancellation or deadline here when child
+    // tasks are running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
+    // Children keep their own references to the shared context.
+    promise.context.reset();
     co_await latch;
     if (eptr) {
         std::rethrow_exception(eptr);
@@ -86,17 +157,18 @@ Task<std::vector<std::any>> all(Task<Args>... tasks) {
 
     std::vector<std::any> results(count);
     Latch latch {static_cast<std::ptrdiff_t>(count)};
-    auto executor = co_await currentExecutor;
     std::exception_ptr eptr = nullptr;
 
     PromiseBase& promise = co_await currentPromise;
+    Executor* executor = promise.executor.get();
     size_t idx = 0;
     (executor->next(detail::runAndNotify(std::move(tasks), latch, eptr, &results[idx++]).setContext(promise.context)),
      ...);
 
-    // Reset stop token before awaiting for the latch, so we don't wake up from cancellation here when child tasks are
-    // running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
-    promise.context.stopToken.reset();
+    // Reset context before awaiting for the latch, so we don't wake up from cancellation or deadline here when child
+    // tasks are running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
+    // Children keep their own references to the shared context.
+    promise.context.reset();
     co_await latch;
     if (eptr) {
         std::rethrow_exception(eptr);
@@ -112,17 +184,18 @@ Task<std::vector<T>> all(std::vector<Task<T>> tasks) {
     const size_t count = tasks.size();
     std::vector<T> results(count);
     Latch latch {static_cast<std::ptrdiff_t>(count)};
-    auto executor = co_await currentExecutor;
     std::exception_ptr eptr = nullptr;
 
     PromiseBase& promise = co_await currentPromise;
+    Executor* executor = promise.executor.get();
     for (size_t i = 0; i < tasks.size(); ++i) {
         executor->next(detail::runAndNotify(std::move(tasks[i]), latch, eptr, &results[i]).setContext(promise.context));
     }
 
-    // Reset stop token before awaiting for the latch, so we don't wake up from cancellation here when child tasks are
-    // running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
-    promise.context.stopToken.reset();
+    // Reset context before awaiting for the latch, so we don't wake up from cancellation or deadline here when child
+    // tasks are running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
+    // Children keep their own references to the shared context.
+    promise.context.reset();
     co_await latch;
     if (eptr) {
         std::rethrow_exception(eptr);
@@ -134,22 +207,88 @@ inline Task<void> all(std::vector<Task<void>> tasks) {
     if (tasks.empty()) {
         co_return;
     }
-    auto executor = co_await currentExecutor;
     Latch latch {static_cast<std::ptrdiff_t>(tasks.size())};
     std::exception_ptr eptr = nullptr;
 
     PromiseBase& promise = co_await currentPromise;
+    Executor* executor = promise.executor.get();
     for (auto& task : tasks) {
         executor->next(detail::runAndNotify<void>(std::move(task), latch, eptr, nullptr).setContext(promise.context));
     }
 
-    // Reset stop token before awaiting for the latch, so we don't wake up from cancellation here when child tasks are
-    // running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
-    promise.context.stopToken.reset();
+    // Reset context before awaiting for the latch, so we don't wake up from cancellation or deadline here when child
+    // tasks are running, this way we will wait while all child tasks cancel and trigger the latch for correct handling.
+    // Children keep their own references to the shared context.
+    promise.context.reset();
     co_await latch;
     if (eptr) {
         std::rethrow_exception(eptr);
     }
 }
 
+/**
+ * Fork-join mode of the coro::all(), designed for the multi threaded work stealing executors like
+ * coro::ThreadPoolExecutor. The first child is executed inline on the current thread, while the rest are exposed for
+ * the idle workers to steal. The awaiting coroutine is resumed by the last finished child, using lock free atomic
+ * countdown rather than a Latch.
+ * Stop token is inherited by the children, and the first error thrown by any of them is rethrown after all of them are
+ * joined.
+ */
+template <typename T>
+Task<std::vector<T>> forkJoin(std::vector<Task<T>> tasks) {
+    if (tasks.empty()) {
+        co_return {};
+    }
+    std::vector<T> results(tasks.size());
+    detail::JoinCounter join {tasks.size()};
+    std::vector<Task<void>> children;
+    children.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        children.push_back(detail::runAndJoin(std::move(tasks[i]), join, &results[i]));
+    }
+    co_await detail::ForkAwaitable {join, children};
+    co_return std::move(results);
+}
+
+inline Task<void> forkJoin(std::vector<Task<void>> tasks) {
+    if (tasks.empty()) {
+        co_return;
+    }
+    detail::JoinCounter join {tasks.size()};
+    std::vector<Task<void>> children;
+    children.reserve(tasks.size());
+    for (auto& task : tasks) {
+        children.push_back(detail::runAndJoin<void>(std::move(task), join, nullptr));
+    }
+    co_await detail::ForkAwaitable {join, children};
+}
+
+template <typename... Args>
+    requires(std::same_as<Args, void> && ...)
+Task<void> forkJoin(Task<Args>... tasks) {
+    constexpr size_t count = sizeof...(tasks);
+    static_assert(count >= 2, "It does not make sense to use coro::forkJoin() with <2 arguments...");
+    detail::JoinCounter join {count};
+    std::vector<Task<void>> children;
+    children.reserve(count);
+    (children.push_back(detail::runAndJoin<void>(std::move(tasks), join, nullptr)), ...);
+    co_await detail::ForkAwaitable {join, children};
+}
+
+template <typename T, typename... Args>
+    requires(std::same_as<Args, T> && ... && !std::same_as<T, void>)
+Task<std::vector<T>> forkJoin(Task<T> first, Task<Args>... rest) {
+    constexpr size_t count = 1 + sizeof...(rest);
+    static_assert(count >= 2, "It does not make sense to use coro::forkJoin() with <2 arguments...");
+    std::vector<T> results(count);
+    detail::JoinCounter join {count};
+    std::vector<Task<void>> children;
+    children.reserve(count);
+    children.push_back(detail::runAndJoin(std::move(first), join, &results[0]));
+    size_t idx = 1;
+    (children.push_back(detail::runAndJoin(std::move(rest), join, &results[idx++])), ...);
+    co_await detail::ForkAwaitable {join, children};
+    co_return std::move(results);
+}
+
 } // namespace coro
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+template <typename A>
+struct NoThrow {
+    A awaitable;
+};
+
+/**
+ * Adapter reporting the outcome of the awaited operation as coro::Result instead of throwing.
+ * Works with any awaitable supported by the coro::Task, e.g. tasks, mutexes, latches, pipe reads and sleeps.
+ * Built-in awaitables report cancellation as the stopped Result without creating or throwing StopError, and tasks
+ * pass their stored exception_ptr as is without rethrowing it, so it is cheap to cancel large amounts of tasks.
+ * Other awaitables fall back to catching the exception thrown from their await_resume().
+ * Awaiting a task which itself returns Result<T> yields Result<T> rather than Result<Result<T>>.
+ * ```
+ * auto result = co_await coro::nothrow(fetch(url));
+ * if (result.isStopped()) {
+ *     co_return;
+ * }
+ * ```
+ */
+template <typename A>
+NoThrow<A> nothrow(A&& awaitable) {
+    return NoThrow<A> {std::forward<A>(awaitable)};
+}
+
+namespace detail {
+
+template <typename T>
+struct IsResult : std::false_type {};
+
+template <typename T>
+struct IsResult<Result<T>> : std::true_type {};
+
+template <typename Awaitable>
+class NoThrowAwaitable {
+    using Return = decltype(std::declval<Awaitable&>().await_resume());
+    using NoThrowResult = std::conditional_t<IsResult<std::remove_cvref_t<Return>>::value,
+                                             std::remove_cvref_t<Return>,
+                                             Result<Return>>;
+
+public:
+    NoThrowAwaitable(Awaitable&& awaitable)
+        : _awaitable(std::move(awaitable)) {}
+
+    bool await_ready() {
+        // Not exposed as own operator co_await(), since returning awaiter by reference makes gcc copy it.
+        if constexpr (requires { _awaitable.operator co_await(); }) {
+            return _awaitable.operator co_await().await_ready();
+        }
+        return _awaitable.await_ready();
+    }
+
+    template <typename Promise>
+    decltype(auto) await_suspend(std::coroutine_handle<Promise> continuation) {
+        return _awaitable.await_suspend(continuation);
+    }
+
+    NoThrowResult await_resume() {
+        if constexpr (requires { _awaitable.await_resume_result(); }) {
+            return unwrap(_awaitable.await_resume_result());
+        } else {
+            try {
+                if constexpr (std::is_void_v<Return>) {
+                    _awaitable.await_resume();
+                    return Result<void> {};
+                } else {
+                    return unwrap(Result<Return> {_awaitable.await_resume()});
+                }
+            } catch (...) {
+                return NoThrowResult {std::current_exception()};
+            }
+        }
+    }
+
+private:
+    template <typename T>
+    static NoThrowResult unwrap(Result<T>&& result) {
+        if constexpr (std::is_same_v<Result<T>, NoThrowResult>) {
+            return std::move(result);
+        } else if (result.hasValue()) {
+            return std::move(result).value();
+        } else if (result.hasError()) {
+            return NoThrowResult {result.error()};
+        } else {
+            return NoThrowResult::stopped();
+        }
+    }
+
+private:
+    Awaitable _awaitable;
+};
+
+} // namespace detail
+
+template <typename A>
+struct await_ready_trait<NoThrow<A>> {
+    static auto await_transform(PromiseBase& promise, NoThrow<A>&& nothrow) {
+        using Awaitable = std::remove_cvref_t<decltype(promise.await_transform(std::forward<A>(nothrow.awaitable)))>;
+        return detail::NoThrowAwaitable<Awaitable> {promise.await_transform(std::forward<A>(nothrow.awaitable))};
+    }
+};
+
+} // namespace coro
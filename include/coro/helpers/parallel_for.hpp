@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../core/promise.hpp"
+#include "../core/task.hpp"
+#include "../detail/join.hpp"
+#include "../executors/executor_group.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+namespace coro {
+
+namespace detail {
+
+/**
+ * Index range shared between parallel workers. Workers claim chunks of the range via single atomic cursor,
+ * so faster workers naturally take more chunks than slower ones.
+ * When grain size is 0 chunk sizes are picked adaptively (guided scheduling): each claim takes a share of the
+ * remaining range proportional to the worker count, so the first chunks are large and the tail is split finely
+ * to keep all workers busy till the end.
+ */
+template <std::integral I>
+class ParallelRange {
+public:
+    ParallelRange(I begin, I end, I grainSize, size_t workers)
+        : _begin(begin)
+        , _size(end > begin ? static_cast<size_t>(end - begin) : 0)
+        , _grain(grainSize > 0 ? static_cast<size_t>(grainSize) : 0)
+        , _workers(std::max<size_t>(workers, 1)) {}
+
+    /// Returns count of workers worth spawning for this range, which is never more than the count of chunks.
+    size_t workers() const {
+        const size_t chunks = _grain ? (_size + _grain - 1) / _grain : _size;
+        return std::min(_workers, chunks);
+    }
+
+    /// Claims next chunk [first, last), returns false if the whole range was already claimed.
+    bool claim(I& first, I& last) {
+        size_t pos = _cursor.load(std::memory_order_relaxed);
+        while (pos < _size) {
+            const size_t remaining = _size - pos;
+            const size_t chunk = _grain ? _grain : std::max<size_t>(1, remaining / (2 * _workers));
+            const size_t next = pos + std::min(chunk, remaining);
+            if (_cursor.compare_exchange_weak(pos, next, std::memory_order_relaxed)) {
+                first = static_cast<I>(_begin + static_cast<I>(pos));
+                last = static_cast<I>(_begin + static_cast<I>(next));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Marks the whole range as claimed, so workers stop after their current chunk.
+    void cancel() {
+        _cursor.store(_size, std::memory_order_relaxed);
+    }
+
+private:
+    const I _begin;
+    const size_t _size;
+    const size_t _grain;
+    const size_t _workers;
+    std::atomic<size_t> _cursor = 0;
+};
+
+template <std::integral I, typename Body>
+Task<void> parallelWorker(size_t worker, ParallelRange<I>& range, JoinCounter& join, Body& body) {
+    const StopToken& stopToken = co_await currentStopToken;
+    try {
+        I first;
+        I last;
+        while (!stopToken.stopRequested() && range.claim(first, last)) {
+            body(worker, first, last);
+        }
+    } catch (...) {
+        join.fail(std::current_exception());
+        range.cancel();
+    }
+    PromiseBase& promise = co_await currentPromise;
+    join.arrive(promise.executor.get());
+}
+
+/// Runs body over the range on the executors of the group and returns count of the spawned workers.
+template <std::integral I, typename Body>
+Task<size_t> parallelRun(const ExecutorGroup& group, I begin, I end, I grainSize, Body& body) {
+    if (group.empty()) {
+        throw std::invalid_argument {"coro::parallelFor: empty executor group"};
+    }
+    ParallelRange<I> range {begin, end, grainSize, group.size()};
+    const size_t workers = range.workers();
+    if (workers == 0) {
+        co_return 0;
+    }
+    JoinCounter join {workers};
+    PromiseBase& promise = co_await currentPromise;
+    const ContextRef& context = promise.context;
+    for (size_t i = 0; i < workers; ++i) {
+        group[i]->schedule(parallelWorker(i, range, join, body).setContext(context));
+    }
+    co_await join;
+    context->stopToken.throwIfStopped();
+    co_return workers;
+}
+
+} // namespace detail
+
+/**
+ * Invokes fn(i) for every index in [begin, end) on the executors of the given group, and resumes the awaiting
+ * coroutine once all of them are processed.
+ * The range is split into chunks of grainSize indices, or into adaptively sized chunks if grainSize is 0.
+ * At most one worker per executor is spawned, and workers keep claiming chunks till the range is exhausted, so fn
+ * should be safe to call concurrently with different indices.
+ * The first exception thrown by fn stops claiming of new chunks and is rethrown to the awaiter, the same happens on
+ * cancellation via the stop token of the awaiting coroutine. Empty group throws std::invalid_argument.
+ * ```
+ * co_await coro::parallelFor(group, size_t {0}, records.size(), size_t {0}, [&](size_t i) { parse(records[i]); });
+ * ```
+ */
+template <std::integral I, typename F>
+    requires std::invocable<F&, I>
+Task<void> parallelFor(ExecutorGroup group, I begin, I end, I grainSize, F fn) {
+    auto body = [&fn](size_t, I first, I last) {
+        for (I i = first; i != last; ++i) {
+            fn(i);
+        }
+    };
+    co_await detail::parallelRun(group, begin, end, grainSize, body);
+}
+
+/**
+ * Reduce variant of the coro::parallelFor(). Each worker folds map(i) of its chunks into its own partial result,
+ * starting from the identity value, and the partial results are folded in the awaiting coroutine when all workers are
+ * done. So reduce should be associative and identity should be the identity element of it.
+ * ```
+ * size_t total = co_await coro::parallelReduce(group, size_t {0}, n, size_t {0}, size_t {0}, mapFn, std::plus<> {});
+ * ```
+ */
+template <std::integral I, typename T, typename Map, typename Reduce>
+    requires std::invocable<Map&, I> && std::invocable<Reduce&, T, std::invoke_result_t<Map&, I>>
+Task<T> parallelReduce(ExecutorGroup group, I begin, I end, I grainSize, T identity, Map map, Reduce reduce) {
+    std::vector<T> partials(group.size(), identity);
+    auto body = [&](size_t worker, I first, I last) {
+        T& partial = partials[worker];
+        for (I i = first; i != last; ++i) {
+            partial = reduce(std::move(partial), map(i));
+        }
+    };
+    const size_t workers = co_await detail::parallelRun(group, begin, end, grainSize, body);
+    T result = std::move(identity);
+    for (size_t i = 0; i < workers; ++i) {
+        result = reduce(std::move(result), std::move(partials[i]));
+    }
+    co_return result;
+}
+
+} // namespace coro
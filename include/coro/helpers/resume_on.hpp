@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../core/executor.hpp"
+#include "../core/handle.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/traits.hpp"
+
+#include <coroutine>
+
+namespace coro {
+
+namespace detail {
+
+class ResumeOnAwaitable {
+public:
+    ResumeOnAwaitable(Executor::Ref executor, bool ready)
+        : _executor(std::move(executor))
+        , _ready(ready) {}
+
+    bool await_ready() noexcept {
+        return _ready;
+    }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
+        // The coroutine might be resumed on the target executor and destroy this awaitable before schedule() returns,
+        // so keep the executor in a local variable.
+        Executor::Ref executor = std::move(_executor);
+        continuation.promise().executor = executor;
+        executor->schedule(CoroHandle::fromTypedHandle(continuation));
+    }
+
+    void await_resume() noexcept {}
+
+private:
+    Executor::Ref _executor;
+    bool _ready;
+};
+
+} // namespace detail
+
+struct ResumeOn {
+    Executor::Ref executor;
+};
+
+/**
+ * Moves execution of the current coroutine to the given executor.
+ * The coroutine frame is scheduled directly on the target executor, and the rest of the coroutine, including the
+ * child tasks it awaits afterwards, runs there. When the coroutine finishes its awaiter is resumed on its own
+ * executor as usual, so it is a single queue push for each direction.
+ * Awaiting is no-op if the coroutine already runs on the given executor.
+ * ```
+ * auto data = co_await readRequest();
+ * co_await coro::resumeOn(cpuPool);
+ * auto response = process(data);
+ * co_await coro::resumeOn(ioExecutor);
+ * co_await writeResponse(response);
+ * ```
+ */
+inline ResumeOn resumeOn(Executor::Ref executor) {
+    return ResumeOn {std::move(executor)};
+}
+
+template <>
+struct await_ready_trait<ResumeOn> {
+    static detail::ResumeOnAwaitable await_transform(const PromiseBase& promise, ResumeOn&& resumeOn) {
+        const bool ready = promise.executor == resumeOn.executor;
+        return detail::ResumeOnAwaitable {std::move(resumeOn.executor), ready};
+    }
+};
+
+} // namespace coro
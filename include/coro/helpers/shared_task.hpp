@@ -0,0 +1,211 @@
+#pragma once
+
+#include "../core/executor.hpp"
+#include "../core/promise.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/task.hpp"
+#include "../core/traits.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace coro {
+
+namespace detail {
+
+/**
+ * State shared between all copies of the SharedTask. Holds the task until the first awaiter starts it,
+ * the list of suspended awaiters, and the result once the task is finished.
+ */
+template <typename R>
+class SharedTaskState {
+public:
+    using Ref = std::shared_ptr<SharedTaskState>;
+    using Return = std::conditional_t<std::is_void_v<R>, std::type_identity<void>, std::add_lvalue_reference<const R>>::type;
+
+    SharedTaskState(Task<R>&& task)
+        : _task(std::move(task)) {
+        // The task is shared between awaiters, so it should not take over the context of whichever awaits it first.
+        _task.handle().promise().enableContextInheritance(false);
+    }
+
+    bool finished() const {
+        return _finished.load(std::memory_order_acquire);
+    }
+
+    Return result() const {
+        if (_exception) {
+            std::rethrow_exception(_exception);
+        }
+        if constexpr (!std::is_void_v<R>) {
+            return *_value;
+        }
+    }
+
+    Result<Return> resultOrError() const {
+        if (_exception) {
+            return Result<Return> {_exception};
+        }
+        if constexpr (std::is_void_v<R>) {
+            return Result<void> {};
+        } else {
+            return Result<Return> {*_value};
+        }
+    }
+
+    /// Queues the awaiter to be resumed when the result is ready, and starts the task if this is the first awaiter.
+    /// Returns false if the result is already available, so there is no need to suspend.
+    static bool wait(const Ref& state, CoroHandle awaiter, Executor::TaskRef executor) {
+        bool start = false;
+        {
+            std::scoped_lock lock {state->_mutex};
+            if (state->finished()) {
+                return false;
+            }
+            state->_waiters.push_back(Waiter {executor.get(), std::move(awaiter)});
+            start = !std::exchange(state->_started, true);
+        }
+        // Nothing from the awaiter should be touched from here on, it might be already released on another thread,
+        // so the executor is kept in the local copy while starting the task.
+        if (start) {
+            executor->next(run(state));
+        }
+        return true;
+    }
+
+private:
+    static Task<void> run(Ref state) {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                co_await std::move(state->_task);
+            } else {
+                state->_value.emplace(co_await std::move(state->_task));
+            }
+        } catch (...) {
+            state->_exception = std::current_exception();
+        }
+        state->release();
+    }
+
+    void release() {
+        std::vector<Waiter> waiters;
+        {
+            std::scoped_lock lock {_mutex};
+            _finished.store(true, std::memory_order_release);
+            waiters = std::move(_waiters);
+        }
+        WakeList wakeList;
+        for (auto& waiter : waiters) {
+            wakeList.push(waiter.executor, std::move(waiter.handle));
+        }
+        wakeList.schedule();
+    }
+
+private:
+    struct Waiter {
+        // kept alive by the suspended awaiter
+        Executor* executor;
+        CoroHandle handle;
+    };
+
+    Task<R> _task;
+    std::conditional_t<std::is_void_v<R>, std::monostate, std::optional<R>> _value;
+    std::exception_ptr _exception;
+    std::vector<Waiter> _waiters;
+    std::mutex _mutex;
+    std::atomic<bool> _finished = false;
+    bool _started = false;
+};
+
+} // namespace detail
+
+/**
+ * Copyable handle of the task, which can be co_await(ed) from any number of coroutines running on any executors.
+ * The task is started by the first awaiter on its executor and is executed only once. When it is finished all
+ * suspended awaiters are released as a single batch per executor, while the awaiters coming after that get the stored
+ * result right away, without suspension.
+ * Awaiting returns a const reference to the stored result, which stays valid while any copy of the SharedTask exists.
+ * If the task throws, the same exception is rethrown to every awaiter.
+ * The task keeps its own context instead of inheriting it from the awaiters, so stopping one of the awaiters does not
+ * cancel the computation for the others. The stop token of the awaiter is checked when it is resumed.
+ * ```
+ * coro::SharedTask<Config> config = loadConfig();
+ * // in any number of coroutines
+ * const Config& cfg = co_await config;
+ * ```
+ */
+template <typename R>
+class SharedTask {
+public:
+    using Type = R;
+
+    SharedTask(Task<R>&& task)
+        : _state(std::make_shared<detail::SharedTaskState<R>>(std::move(task))) {}
+
+public:
+    /// Returns true if the task is finished and awaiting it will not suspend.
+    bool ready() const {
+        return _state->finished();
+    }
+
+private:
+    friend struct await_ready_trait<SharedTask<R>>;
+    typename detail::SharedTaskState<R>::Ref _state;
+};
+
+namespace detail {
+
+template <typename R>
+class SharedTaskAwaitable {
+public:
+    SharedTaskAwaitable(typename SharedTaskState<R>::Ref state, const PromiseBase& promise)
+        : _state(std::move(state))
+        , _promise(&promise) {}
+
+    bool await_ready() noexcept {
+        return _state->finished();
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> awaiter) {
+        // keep the state alive locally, since this awaitable might be destroyed by the resumed awaiter
+        auto state = _state;
+        return SharedTaskState<R>::wait(state, CoroHandle::fromTypedHandle(awaiter), awaiter.promise().executor);
+    }
+
+    SharedTaskState<R>::Return await_resume() {
+        _promise->context->stopToken.throwIfStopped();
+        return _state->result();
+    }
+
+    Result<typename SharedTaskState<R>::Return> await_resume_result() {
+        if (_promise->context->stopToken.stopRequested()) {
+            return Result<typename SharedTaskState<R>::Return>::stopped();
+        }
+        return _state->resultOrError();
+    }
+
+private:
+    typename SharedTaskState<R>::Ref _state;
+    const PromiseBase* _promise;
+};
+
+} // namespace detail
+
+template <typename R>
+struct await_ready_trait<SharedTask<R>> {
+    static detail::SharedTaskAwaitable<R> await_transform(const PromiseBase& promise, const SharedTask<R>& task) {
+        return {task._state, promise};
+    }
+};
+
+} // namespace coro
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+
+namespace coro {
+
+class Barrier;
+namespace detail {
+class BarrierAwaitable;
+}
+
+/**
+ * Request to arrive at the Barrier and wait till the phase completes, should be co_await(ed).
+ */
+struct BarrierArriveAndWait {
+    Barrier& barrier;
+};
+
+/**
+ * Reusable barrier synchronizing the fixed set of coroutines in phases.
+ * Example usage: `co_await barrier.arriveAndWait();` at the end of every round in each participant.
+ * The phase completes when the expected number of participants has arrived, then the optional completion function is
+ * run once by the last arriving participant, and all waiters are released with a single batched schedule per
+ * executor. The barrier is reset for the next phase right away, so the same participants can keep using it.
+ * Arrival is a single atomic decrement, the lock is taken only by the waiters which have to suspend and by the
+ * completion of the phase. Waiter is woken up early and removed from the queue in O(1) when its task is stopped or
+ * its deadline expires, its arrival is still counted though, so it should not arrive again before the phase completes.
+ */
+class Barrier {
+public:
+    using Completion = std::function<void()>;
+
+    /// The completion function is invoked on the thread of the last arriving participant and should not throw.
+    explicit Barrier(std::ptrdiff_t expected, Completion completion = {})
+        : _state(static_cast<uint32_t>(expected))
+        , _expected(expected)
+        , _completion(std::move(completion)) {}
+
+    ~Barrier() {
+        if (!_waiters.empty()) {
+            std::abort();
+        }
+    }
+
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+
+public:
+    BarrierArriveAndWait arriveAndWait() {
+        return BarrierArriveAndWait {*this};
+    }
+
+    /// Arrives at the barrier without waiting and decrements the expected count of the subsequent phases.
+    void arriveAndDrop() noexcept {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        uint32_t phase;
+        arrive(phase);
+    }
+
+private:
+    friend detail::BarrierAwaitable;
+
+    /// Decrements the count of the current phase and stores the phase in the argument.
+    /// Completes the phase and returns true if this was the last expected arrival.
+    bool arrive(uint32_t& phase) noexcept;
+
+    /// Runs the completion function, starts the next phase and releases all waiters.
+    void completePhase(uint32_t phase) noexcept;
+
+    /// Queues the awaiter, returns false if its phase is already completed or the awaiter was cancelled.
+    bool queue(detail::BarrierAwaitable* awaiter);
+
+    /// Removes the cancelled awaiter from the queue in O(1), returns false if it is not queued.
+    bool remove(detail::BarrierAwaitable* awaiter);
+
+private:
+    // Phase number is stored in the upper half of the state, remaining count of the current phase in the lower one.
+    static constexpr uint64_t CountMask = 0xffffffff;
+    static constexpr int PhaseShift = 32;
+
+    std::atomic<uint64_t> _state;
+    // Expected count of the next phases, modified only by the phase completion
+    std::ptrdiff_t _expected;
+    std::atomic<std::ptrdiff_t> _dropped = 0;
+    Completion _completion;
+    detail::IntrusiveList<detail::BarrierAwaitable> _waiters;
+    std::mutex _mutex;
+};
+
+namespace detail {
+
+class BarrierAwaitable : public IntrusiveListNode<BarrierAwaitable> {
+private:
+    friend await_ready_trait<BarrierArriveAndWait>;
+    BarrierAwaitable(Barrier* barrier, const PromiseBase& promise)
+        : _barrier(barrier)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    BarrierAwaitable(BarrierAwaitable&& other) noexcept
+        : _barrier(other._barrier)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() noexcept {
+        // arrives in any case, so the other participants are not blocked by the failing one
+        _released = _barrier->arrive(_phase);
+        // expired deadline fails fast in await_resume()
+        return _released || detail::deadlineExceeded(_deadline);
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the awaiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _barrier->queue(this);
+    }
+
+    void await_resume() {
+        _canceller.disarm();
+        _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
+        if (_stopToken.stopRequested()) {
+            return Result<void>::stopped();
+        }
+        if (detail::deadlineExceeded(_deadline)) {
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend Barrier;
+    friend WaitCanceller<BarrierAwaitable>;
+
+    void cancel() {
+        if (_barrier->remove(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    Barrier* _barrier;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<BarrierAwaitable> _canceller;
+    uint32_t _phase = 0;
+    // Guarded by the barrier mutex while the awaiter is suspended
+    bool _released = false;
+    bool _cancelled = false;
+};
+
+} // namespace detail
+
+inline bool Barrier::arrive(uint32_t& phase) noexcept {
+    // acq_rel chains all arrivals of the phase, so the last one sees the memory of the others, including the drops
+    const uint64_t state = _state.fetch_sub(1, std::memory_order_acq_rel);
+    phase = static_cast<uint32_t>(state >> PhaseShift);
+    if ((state & CountMask) != 1) {
+        return false;
+    }
+    completePhase(phase);
+    return true;
+}
+
+inline void Barrier::completePhase(uint32_t phase) noexcept {
+    // All participants have arrived and nobody can arrive at the next phase yet, so no lock is needed here.
+    if (_completion) {
+        _completion();
+    }
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _expected -= _dropped.exchange(0, std::memory_order_relaxed);
+        const uint64_t next = static_cast<uint64_t>(static_cast<uint32_t>(phase + 1)) << PhaseShift;
+        _state.store(next | static_cast<uint32_t>(_expected), std::memory_order_release);
+        while (auto* waiter = _waiters.popFront()) {
+            waiter->_released = true;
+            wakeList.push(waiter->_executor, waiter->_continuation);
+        }
+    }
+    wakeList.schedule();
+}
+
+inline bool Barrier::queue(detail::BarrierAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (awaiter->_cancelled) {
+        return false;
+    }
+    // the phase is changed only under the mutex, so it is either already completed or the completion will find
+    // the awaiter in the queue
+    if (static_cast<uint32_t>(_state.load(std::memory_order_acquire) >> PhaseShift) != awaiter->_phase) {
+        awaiter->_released = true;
+        return false;
+    }
+    _waiters.pushBack(awaiter);
+    return true;
+}
+
+inline bool Barrier::remove(detail::BarrierAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (!awaiter->linked()) {
+        // either already released, or cancelled before being queued
+        awaiter->_cancelled = !awaiter->_released;
+        return false;
+    }
+    _waiters.remove(awaiter);
+    return true;
+}
+
+template <>
+struct await_ready_trait<BarrierArriveAndWait> {
+    static detail::BarrierAwaitable await_transform(const PromiseBase& promise, BarrierArriveAndWait request) {
+        return detail::BarrierAwaitable {&request.barrier, promise};
+    }
+};
+
+} // namespace coro
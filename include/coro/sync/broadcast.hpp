@@ -0,0 +1,589 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coro {
+
+template <typename T>
+class Broadcast;
+
+template <typename T>
+class BroadcastSubscriber;
+
+namespace detail {
+template <typename T>
+class BroadcastReadAwaitable;
+
+template <typename T>
+class BroadcastWriteAwaitable;
+} // namespace detail
+
+/**
+ * Behavior of the Broadcast when the slowest subscriber lags behind by the whole capacity.
+ */
+enum class BroadcastPolicy {
+    /// The oldest item is dropped for the lagging subscribers, which skip to the oldest available item.
+    DropOldest,
+    /// The publisher is suspended till the slowest subscriber reads the oldest item.
+    Block,
+};
+
+/**
+ * Request to read the next item of the subscriber, should be co_await(ed).
+ */
+template <typename T>
+struct [[nodiscard]] BroadcastReader {
+    BroadcastSubscriber<T>& subscriber;
+};
+
+/**
+ * Request to publish the item, should be co_await(ed).
+ */
+template <typename T>
+struct [[nodiscard]] BroadcastWriter {
+    Broadcast<T>& broadcast;
+    T data;
+};
+
+/**
+ * Asynchronous single producer or multiple producer broadcast channel, every subscriber receives every item
+ * published after it has subscribed.
+ * Example usage:
+ * @code
+ * coro::Broadcast<Event> events {1024};
+ * auto subscriber = events.subscribe();
+ * // consumer
+ * Event event = co_await subscriber.next();
+ * // producer
+ * co_await events.publish(event);
+ * @endcode
+ * Items are stored once in the shared ring of the given capacity, and each subscriber keeps its own cursor into it,
+ * so publishing is a single write and a single batched schedule per executor of the subscribers waiting for the next
+ * item, regardless of the number of subscribers. Subscribers copy the items out of the ring, and the slot is freed
+ * once all subscribers have read it. When the slowest subscriber lags behind by the whole capacity, the DropOldest
+ * policy overwrites the oldest item and the lagging subscribers skip it, see BroadcastSubscriber::missed(), while the
+ * Block policy suspends the publishers instead. Suspended subscriber or publisher is woken up early and removed from
+ * the queue in O(1) when its task is stopped or its deadline expires.
+ */
+template <typename T>
+class Broadcast {
+public:
+    explicit Broadcast(size_t capacity, BroadcastPolicy policy = BroadcastPolicy::DropOldest)
+        : _slots(std::max<size_t>(capacity, 1))
+        , _policy(policy) {}
+
+    ~Broadcast() {
+        if (!_readers.empty() || !_writers.empty()) {
+            std::abort();
+        }
+    }
+
+    Broadcast(const Broadcast&) = delete;
+    Broadcast& operator=(const Broadcast&) = delete;
+
+public:
+    /// Subscribes to the items published from now on, the subscriber should not outlive the broadcast.
+    BroadcastSubscriber<T> subscribe();
+
+    /// Publishes the item suspending while the ring is full in the Block mode, should be co_await(ed).
+    [[nodiscard]] BroadcastWriter<T> publish(T data) {
+        return BroadcastWriter<T> {*this, std::move(data)};
+    }
+
+    /// Publishes the item if the ring is not full or the policy is DropOldest, returns false without consuming the
+    /// data otherwise. Items published without subscribers are dropped right away.
+    bool tryPublish(T&& data);
+
+    bool tryPublish(const T& data) {
+        T copy = data;
+        return tryPublish(std::move(copy));
+    }
+
+    size_t capacity() const noexcept {
+        return _slots.size();
+    }
+
+private:
+    friend BroadcastSubscriber<T>;
+    friend detail::BroadcastReadAwaitable<T>;
+    friend detail::BroadcastWriteAwaitable<T>;
+
+    struct Slot {
+        std::optional<T> data;
+        // Count of the subscribers which have not read the item yet
+        size_t pending = 0;
+    };
+
+    Slot& slot(uint64_t sequence) {
+        return _slots[sequence % _slots.size()];
+    }
+
+    /// Stores the item and releases all subscribers waiting for it, returns false if the ring is full.
+    /// Should be called under the mutex.
+    bool push(T& data, detail::WakeList& wakeList);
+
+    /// Frees the slots read by all subscribers and lets the queued publishers take them.
+    /// Should be called under the mutex.
+    void release(detail::WakeList& wakeList);
+
+    /// Copies the next item of the subscriber, should be called under the mutex.
+    std::optional<T> pop(BroadcastSubscriber<T>& subscriber, detail::WakeList& wakeList);
+
+    std::optional<T> tryRead(BroadcastSubscriber<T>& subscriber);
+
+    void unsubscribe(BroadcastSubscriber<T>& subscriber);
+
+    /// Reads the item or queues the reader, returns true if the reader was queued.
+    bool readOrQueue(detail::BroadcastReadAwaitable<T>* reader);
+
+    /// Publishes the item or queues the writer, returns true if the writer was queued.
+    bool writeOrQueue(detail::BroadcastWriteAwaitable<T>* writer);
+
+    /// Removes the cancelled reader from the queue in O(1), returns false if it is not queued.
+    bool removeReader(detail::BroadcastReadAwaitable<T>* reader);
+
+    /// Removes the cancelled writer from the queue in O(1), returns false if it is not queued.
+    bool removeWriter(detail::BroadcastWriteAwaitable<T>* writer);
+
+private:
+    std::vector<Slot> _slots;
+    const BroadcastPolicy _policy;
+    // Sequence of the oldest stored item and of the next published one
+    uint64_t _head = 0;
+    uint64_t _tail = 0;
+    size_t _subscribers = 0;
+    detail::IntrusiveList<detail::BroadcastReadAwaitable<T>> _readers;
+    detail::IntrusiveList<detail::BroadcastWriteAwaitable<T>> _writers;
+    std::mutex _mutex;
+};
+
+/**
+ * Cursor of the single consumer into the Broadcast, unsubscribes on destruction.
+ * Should be used by one coroutine at a time.
+ */
+template <typename T>
+class BroadcastSubscriber {
+public:
+    ~BroadcastSubscriber() {
+        if (_broadcast) {
+            _broadcast->unsubscribe(*this);
+        }
+    }
+
+    BroadcastSubscriber(BroadcastSubscriber&& other) noexcept
+        : _broadcast(std::exchange(other._broadcast, nullptr))
+        , _cursor(other._cursor)
+        , _missed(other._missed) {}
+
+    BroadcastSubscriber& operator=(BroadcastSubscriber&& other) noexcept {
+        if (this != &other) {
+            if (_broadcast) {
+                _broadcast->unsubscribe(*this);
+            }
+            _broadcast = std::exchange(other._broadcast, nullptr);
+            _cursor = other._cursor;
+            _missed = other._missed;
+        }
+        return *this;
+    }
+
+public:
+    /// Reads the next item suspending till it is published, should be co_await(ed).
+    [[nodiscard]] BroadcastReader<T> next() {
+        return BroadcastReader<T> {*this};
+    }
+
+    /// Reads the next item if it is already published without waiting.
+    std::optional<T> tryNext() {
+        return _broadcast->tryRead(*this);
+    }
+
+    /// Count of the items dropped by the DropOldest policy before this subscriber could read them.
+    uint64_t missed() const noexcept {
+        return _missed;
+    }
+
+private:
+    friend Broadcast<T>;
+    friend detail::BroadcastReadAwaitable<T>;
+
+    BroadcastSubscriber(Broadcast<T>* broadcast, uint64_t cursor)
+        : _broadcast(broadcast)
+        , _cursor(cursor) {}
+
+private:
+    Broadcast<T>* _broadcast;
+    // Guarded by the broadcast mutex
+    uint64_t _cursor;
+    uint64_t _missed = 0;
+};
+
+namespace detail {
+
+template <typename T>
+class BroadcastReadAwaitable : public IntrusiveListNode<BroadcastReadAwaitable<T>> {
+public:
+    BroadcastReadAwaitable(BroadcastReader<T> reader, const PromiseBase& promise)
+        : _subscriber(reader.subscriber)
+        , _broadcast(reader.subscriber._broadcast)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    BroadcastReadAwaitable(BroadcastReadAwaitable&& other) noexcept
+        : _subscriber(other._subscriber)
+        , _broadcast(other._broadcast)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast in await_resume() without consuming the item
+            return true;
+        }
+        _data = _broadcast->tryRead(_subscriber);
+        return _data.has_value();
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the reader is never resumed while the callbacks are being registered.
+        // If the stop was already requested the reader is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _broadcast->readOrQueue(this);
+    }
+
+    T await_resume() {
+        _canceller.disarm();
+        if (!received()) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        return std::move(_data).value();
+    }
+
+    Result<T> await_resume_result() {
+        _canceller.disarm();
+        if (!received()) {
+            if (_stopToken.stopRequested()) {
+                return Result<T>::stopped();
+            }
+            return Result<T> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<T> {std::move(_data).value()};
+    }
+
+private:
+    /// Released reader copies the item itself, so the publisher does not copy it for every subscriber.
+    bool received() {
+        if (!_data && _released) {
+            _data = _broadcast->tryRead(_subscriber);
+        }
+        return _data.has_value();
+    }
+
+    friend Broadcast<T>;
+    friend WaitCanceller<BroadcastReadAwaitable>;
+
+    void cancel() {
+        if (_broadcast->removeReader(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    BroadcastSubscriber<T>& _subscriber;
+    Broadcast<T>* _broadcast;
+    std::optional<T> _data;
+    // Guarded by the broadcast mutex while the reader is suspended
+    bool _released = false;
+    bool _cancelled = false;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<BroadcastReadAwaitable> _canceller;
+};
+
+template <typename T>
+class BroadcastWriteAwaitable : public IntrusiveListNode<BroadcastWriteAwaitable<T>> {
+public:
+    BroadcastWriteAwaitable(BroadcastWriter<T>&& writer, const PromiseBase& promise)
+        : _broadcast(&writer.broadcast)
+        , _data(std::move(writer.data))
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    BroadcastWriteAwaitable(BroadcastWriteAwaitable&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : _broadcast(other._broadcast)
+        , _data(std::move(other._data))
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without publishing
+            return true;
+        }
+        _written = _broadcast->tryPublish(std::move(_data));
+        return _written;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the writer is never resumed while the callbacks are being registered.
+        // If the stop was already requested the writer is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _broadcast->writeOrQueue(this);
+    }
+
+    /// Returns normally once the item is published, even if the task was stopped meanwhile.
+    void await_resume() {
+        _canceller.disarm();
+        if (!_written) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
+        if (!_written) {
+            if (_stopToken.stopRequested()) {
+                return Result<void>::stopped();
+            }
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend Broadcast<T>;
+    friend WaitCanceller<BroadcastWriteAwaitable>;
+
+    void cancel() {
+        if (_broadcast->removeWriter(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    Broadcast<T>* _broadcast;
+    // Taken by the subscriber freeing the slot under the broadcast mutex while the writer is suspended
+    T _data;
+    bool _written = false;
+    bool _cancelled = false;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<BroadcastWriteAwaitable> _canceller;
+};
+
+} // namespace detail
+
+template <typename T>
+BroadcastSubscriber<T> Broadcast<T>::subscribe() {
+    std::scoped_lock lock {_mutex};
+    ++_subscribers;
+    return BroadcastSubscriber<T> {this, _tail};
+}
+
+template <typename T>
+void Broadcast<T>::unsubscribe(BroadcastSubscriber<T>& subscriber) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        --_subscribers;
+        for (uint64_t sequence = std::max(subscriber._cursor, _head); sequence < _tail; ++sequence) {
+            --slot(sequence).pending;
+        }
+        release(wakeList);
+    }
+    wakeList.schedule();
+}
+
+template <typename T>
+bool Broadcast<T>::tryPublish(T&& data) {
+    detail::WakeList wakeList;
+    bool written;
+    {
+        std::scoped_lock lock {_mutex};
+        written = push(data, wakeList);
+    }
+    wakeList.schedule();
+    return written;
+}
+
+template <typename T>
+bool Broadcast<T>::push(T& data, detail::WakeList& wakeList) {
+    if (_subscribers == 0) {
+        // nobody to receive the item
+        return true;
+    }
+    if (_tail - _head == _slots.size()) {
+        if (_policy == BroadcastPolicy::Block) {
+            return false;
+        }
+        // lagging subscribers notice the gap and skip to the new head
+        slot(_head).data.reset();
+        ++_head;
+    }
+    Slot& target = slot(_tail);
+    target.data.emplace(std::move(data));
+    target.pending = _subscribers;
+    ++_tail;
+    while (auto* reader = _readers.popFront()) {
+        reader->_released = true;
+        wakeList.push(reader->_executor, reader->_continuation);
+    }
+    return true;
+}
+
+template <typename T>
+void Broadcast<T>::release(detail::WakeList& wakeList) {
+    while (_head < _tail && slot(_head).pending == 0) {
+        slot(_head).data.reset();
+        ++_head;
+    }
+    while (_tail - _head < _slots.size()) {
+        auto* writer = _writers.popFront();
+        if (!writer) {
+            break;
+        }
+        push(writer->_data, wakeList);
+        writer->_written = true;
+        wakeList.push(writer->_executor, writer->_continuation);
+    }
+}
+
+template <typename T>
+std::optional<T> Broadcast<T>::pop(BroadcastSubscriber<T>& subscriber, detail::WakeList& wakeList) {
+    if (subscriber._cursor < _head) {
+        // the items were dropped before the subscriber could read them
+        subscriber._missed += _head - subscriber._cursor;
+        subscriber._cursor = _head;
+    }
+    if (subscriber._cursor == _tail) {
+        return std::nullopt;
+    }
+    Slot& source = slot(subscriber._cursor++);
+    std::optional<T> data {*source.data};
+    if (--source.pending == 0) {
+        release(wakeList);
+    }
+    return data;
+}
+
+template <typename T>
+std::optional<T> Broadcast<T>::tryRead(BroadcastSubscriber<T>& subscriber) {
+    detail::WakeList wakeList;
+    std::optional<T> data;
+    {
+        std::scoped_lock lock {_mutex};
+        data = pop(subscriber, wakeList);
+    }
+    wakeList.schedule();
+    return data;
+}
+
+template <typename T>
+bool Broadcast<T>::readOrQueue(detail::BroadcastReadAwaitable<T>* reader) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        if (reader->_cancelled) {
+            return false;
+        }
+        reader->_data = pop(reader->_subscriber, wakeList);
+        if (!reader->_data) {
+            _readers.pushBack(reader);
+            return true;
+        }
+    }
+    wakeList.schedule();
+    return false;
+}
+
+template <typename T>
+bool Broadcast<T>::writeOrQueue(detail::BroadcastWriteAwaitable<T>* writer) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        if (writer->_cancelled) {
+            return false;
+        }
+        writer->_written = push(writer->_data, wakeList);
+        if (!writer->_written) {
+            _writers.pushBack(writer);
+            return true;
+        }
+    }
+    wakeList.schedule();
+    return false;
+}
+
+template <typename T>
+bool Broadcast<T>::removeReader(detail::BroadcastReadAwaitable<T>* reader) {
+    std::scoped_lock lock {_mutex};
+    if (!reader->linked()) {
+        // either already released, or cancelled before being queued
+        reader->_cancelled = !reader->_released && !reader->_data.has_value();
+        return false;
+    }
+    _readers.remove(reader);
+    return true;
+}
+
+template <typename T>
+bool Broadcast<T>::removeWriter(detail::BroadcastWriteAwaitable<T>* writer) {
+    std::scoped_lock lock {_mutex};
+    if (!writer->linked()) {
+        // either already published, or cancelled before being queued
+        writer->_cancelled = !writer->_written;
+        return false;
+    }
+    _writers.remove(writer);
+    return true;
+}
+
+template <typename T>
+struct await_ready_trait<BroadcastReader<T>> {
+    static detail::BroadcastReadAwaitable<T> await_transform(const PromiseBase& promise, BroadcastReader<T> reader) {
+        return detail::BroadcastReadAwaitable<T> {reader, promise};
+    }
+};
+
+template <typename T>
+struct await_ready_trait<BroadcastWriter<T>> {
+    static detail::BroadcastWriteAwaitable<T> await_transform(const PromiseBase& promise,
+                                                              BroadcastWriter<T>&& writer) {
+        return detail::BroadcastWriteAwaitable<T> {std::move(writer), promise};
+    }
+};
+
+} // namespace coro
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "mutex.hpp"
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+namespace coro {
+
+class ConditionVariable;
+namespace detail {
+class ConditionVariableAwaitable;
+template <typename Predicate>
+class ConditionVariablePredicateAwaitable;
+} // namespace detail
+
+/**
+ * Request to wait for the notification of the ConditionVariable, should be co_await(ed).
+ */
+struct ConditionWait {
+    ConditionVariable& condition;
+    ScopedLock& lock;
+};
+
+/**
+ * Request to wait till the predicate is satisfied, see ConditionVariable::wait().
+ */
+template <typename Predicate>
+struct ConditionWaitUntil {
+    ConditionVariable& condition;
+    ScopedLock& lock;
+    Predicate predicate;
+};
+
+/**
+ * Asynchronous condition variable working together with coro::Mutex.
+ * Example usage:
+ * @code
+ * auto lock = co_await mutex;
+ * co_await condition.wait(lock, [&] { return ready; });
+ * // another coroutine
+ * {
+ *     auto lock = co_await mutex;
+ *     ready = true;
+ * }
+ * condition.notifyAll();
+ * @endcode
+ * wait() unlocks the mutex and queues the coroutine atomically, so a notification sent after the unlock is never
+ * missed. The notified waiter is moved to the queue of the mutex and resumed only once the mutex is locked for it
+ * again, so the waiters released by notifyAll() do not wake up just to contend for the mutex. The predicate is checked
+ * under the lock before suspending and whenever the lock is handed over to the notified waiter, which might happen on
+ * the notifying or the unlocking thread, and the coroutine is resumed only once it is satisfied. Neither of the waits
+ * allocates. Queued waiter is woken up early and removed from the queue in O(1) when its task is stopped or its
+ * deadline expires, in that case the error is thrown and the lock stays released.
+ */
+class ConditionVariable {
+public:
+    ConditionVariable() = default;
+
+    ~ConditionVariable() {
+        if (!_waiters.empty()) {
+            std::abort();
+        }
+    }
+
+    ConditionVariable(const ConditionVariable&) = delete;
+    ConditionVariable& operator=(const ConditionVariable&) = delete;
+
+public:
+    /// Unlocks the lock and waits for the notification, then locks the mutex again.
+    ConditionWait wait(ScopedLock& lock) {
+        return ConditionWait {*this, lock};
+    }
+
+    /// Waits till the predicate is satisfied, the predicate is checked while the mutex is locked.
+    template <typename Predicate>
+    ConditionWaitUntil<Predicate> wait(ScopedLock& lock, Predicate predicate) {
+        return ConditionWaitUntil<Predicate> {*this, lock, std::move(predicate)};
+    }
+
+    /// Resumes the longest waiting coroutine, if any.
+    void notifyOne();
+
+    /// Resumes all waiting coroutines.
+    void notifyAll();
+
+private:
+    friend detail::ConditionVariableAwaitable;
+
+    /// Queues the awaiter, returns false if the awaiter was cancelled and should not wait.
+    bool queue(detail::ConditionVariableAwaitable* awaiter);
+
+    /// Removes the cancelled awaiter from the queue in O(1), returns false if it is not queued.
+    bool remove(detail::ConditionVariableAwaitable* awaiter);
+
+    void notify(bool all);
+
+private:
+    detail::IntrusiveList<detail::ConditionVariableAwaitable> _waiters;
+    std::mutex _mutex;
+};
+
+namespace detail {
+
+/**
+ * Awaitable of ConditionVariable::wait(), which relocks the mutex as its own MutexAwaitable once notified.
+ * The lock is released in any case, even if the wait is cancelled before being queued.
+ */
+class ConditionVariableAwaitable : public MutexAwaitable, public IntrusiveListNode<ConditionVariableAwaitable> {
+protected:
+    friend await_ready_trait<ConditionWait>;
+
+    /// Checks the predicate of the derived awaitable.
+    using Check = bool (*)(ConditionVariableAwaitable* awaiter);
+
+    ConditionVariableAwaitable(ConditionVariable* condition,
+                               ScopedLock& lock,
+                               const PromiseBase& promise,
+                               Check check = nullptr)
+        : MutexAwaitable(lock.mutex(), promise)
+        , _condition(condition)
+        , _lock(&lock)
+        , _check(check) {
+        _onGranted = &ConditionVariableAwaitable::granted;
+    }
+
+public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    ConditionVariableAwaitable(ConditionVariableAwaitable&& other) noexcept
+        : MutexAwaitable(std::move(other))
+        , _condition(other._condition)
+        , _lock(other._lock)
+        , _check(other._check) {
+        _onGranted = &ConditionVariableAwaitable::granted;
+    }
+
+    bool await_ready() {
+        // satisfied predicate does not release the lock at all
+        _satisfied = _check && _check(this);
+        return _satisfied;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // the mutex is unlocked below on behalf of the lock
+        release(*_lock);
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        _waitCanceller.arm(this, _stopToken, _deadline);
+        const bool queued = _condition->queue(this);
+        // Unlocked after queueing, so the notifier, which has locked the mutex after the unlock, always finds the
+        // awaiter queued. The awaiter notified before the unlock is queued to the mutex, and the unlock hands the lock
+        // over to it, so it might be resumed and destroyed during the unlock and is not touched afterwards.
+        unlockMutex();
+        return queued;
+    }
+
+    void await_resume() {
+        _waitCanceller.disarm();
+        if (_satisfied) {
+            return;
+        }
+        if (!_notified) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        *_lock = adopt(_mutex);
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+        _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
+    }
+
+    Result<void> await_resume_result() {
+        _waitCanceller.disarm();
+        if (_satisfied) {
+            return Result<void> {};
+        }
+        if (_notified) {
+            *_lock = adopt(_mutex);
+        }
+        if (_error) {
+            return Result<void> {_error};
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<void>::stopped();
+        }
+        if (!_notified || detail::deadlineExceeded(_deadline)) {
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend ConditionVariable;
+    friend WaitCanceller<ConditionVariableAwaitable>;
+
+    /// Returns whether the awaiter is linked to the condition variable queue, rather than to the mutex one.
+    bool waiting() const noexcept {
+        return detail::IntrusiveListNode<ConditionVariableAwaitable>::linked();
+    }
+
+    void cancel() {
+        if (_condition->remove(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+    /// Notified awaiters relock the mutex without being resumed, and are resumed once the lock is handed over to them.
+    /// They are queued to the mutex at once, split only if they wait with different mutexes.
+    static void relock(IntrusiveList<MutexAwaitable>& notified) {
+        IntrusiveList<MutexAwaitable> batch;
+        while (auto* front = static_cast<ConditionVariableAwaitable*>(notified.front())) {
+            Mutex* mutex = front->_mutex;
+            while (notified.front() && static_cast<ConditionVariableAwaitable*>(notified.front())->_mutex == mutex) {
+                batch.pushBack(notified.popFront());
+            }
+            queueAll(mutex, batch);
+        }
+    }
+
+    /// Called when the mutex is locked for the notified awaiter, which waits for the next notification if its
+    /// predicate is still not satisfied, otherwise it is resumed with the lock. Returns true if the awaiter is queued
+    /// again, then the mutex hands the lock over to the next awaiter.
+    static bool granted(MutexAwaitable* awaiter) {
+        auto* self = static_cast<ConditionVariableAwaitable*>(awaiter);
+        if (!self->_check || self->_stopToken.stopRequested() || detail::deadlineExceeded(self->_deadline)) {
+            return false;
+        }
+        bool satisfied = true;
+        try {
+            satisfied = self->_check(self);
+        } catch (...) {
+            // rethrown from the resumed awaiter, instead of the unlocking thread
+            self->_error = std::current_exception();
+        }
+        // If it is cancelled meanwhile it is resumed with the lock to fail.
+        return !satisfied && self->_condition->queue(self);
+    }
+
+private:
+    ConditionVariable* _condition;
+    ScopedLock* _lock;
+    Check _check;
+    WaitCanceller<ConditionVariableAwaitable> _waitCanceller;
+    std::exception_ptr _error;
+    bool _satisfied = false;
+    // Guarded by the condition variable mutex while the awaiter is suspended
+    bool _notified = false;
+    bool _waitCancelled = false;
+};
+
+/**
+ * Awaitable of ConditionVariable::wait() with the predicate.
+ */
+template <typename Predicate>
+class ConditionVariablePredicateAwaitable : public ConditionVariableAwaitable {
+private:
+    friend await_ready_trait<ConditionWaitUntil<Predicate>>;
+
+    ConditionVariablePredicateAwaitable(ConditionVariable* condition,
+                                        ScopedLock& lock,
+                                        const PromiseBase& promise,
+                                        Predicate&& predicate)
+        : ConditionVariableAwaitable(condition, lock, promise, &ConditionVariablePredicateAwaitable::check)
+        , _predicate(std::move(predicate)) {}
+
+public:
+    ConditionVariablePredicateAwaitable(ConditionVariablePredicateAwaitable&& other) noexcept
+        : ConditionVariableAwaitable(std::move(other))
+        , _predicate(std::move(other._predicate)) {}
+
+private:
+    static bool check(ConditionVariableAwaitable* awaiter) {
+        return static_cast<ConditionVariablePredicateAwaitable*>(awaiter)->_predicate();
+    }
+
+private:
+    Predicate _predicate;
+};
+
+} // namespace detail
+
+template <>
+struct await_ready_trait<ConditionWait> {
+    static detail::ConditionVariableAwaitable await_transform(const PromiseBase& promise, ConditionWait request) {
+        return detail::ConditionVariableAwaitable {&request.condition, request.lock, promise};
+    }
+};
+
+template <typename Predicate>
+struct await_ready_trait<ConditionWaitUntil<Predicate>> {
+    static detail::ConditionVariablePredicateAwaitable<Predicate>
+    await_transform(const PromiseBase& promise, ConditionWaitUntil<Predicate>&& request) {
+        return detail::ConditionVariablePredicateAwaitable<Predicate> {
+            &request.condition, request.lock, promise, std::move(request.predicate)};
+    }
+};
+
+inline void ConditionVariable::notifyOne() {
+    notify(false);
+}
+
+inline void ConditionVariable::notifyAll() {
+    notify(true);
+}
+
+inline bool ConditionVariable::queue(detail::ConditionVariableAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    // The requeued awaiter might have missed its cancellation while being notified, so the stop and the deadline
+    // are checked under the lock the cancellation takes.
+    if (awaiter->_waitCancelled || awaiter->_stopToken.stopRequested() ||
+        detail::deadlineExceeded(awaiter->_deadline)) {
+        return false;
+    }
+    awaiter->_notified = false;
+    _waiters.pushBack(awaiter);
+    return true;
+}
+
+inline bool ConditionVariable::remove(detail::ConditionVariableAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    // notified awaiter is linked to the list of the notifier, rather than to the queue
+    if (awaiter->_notified || !awaiter->waiting()) {
+        // either already notified, or cancelled before being queued
+        awaiter->_waitCancelled = !awaiter->_notified;
+        return false;
+    }
+    _waiters.remove(awaiter);
+    return true;
+}
+
+inline void ConditionVariable::notify(bool all) {
+    detail::IntrusiveList<detail::MutexAwaitable> notified;
+    {
+        std::scoped_lock lock {_mutex};
+        while (auto* waiter = _waiters.popFront()) {
+            waiter->_notified = true;
+            notified.pushBack(waiter);
+            if (!all) {
+                break;
+            }
+        }
+    }
+    detail::ConditionVariableAwaitable::relock(notified);
+}
+
+} // namespace coro
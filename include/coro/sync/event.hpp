@@ -0,0 +1,265 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdlib>
+#include <mutex>
+
+namespace coro {
+
+class Event;
+namespace detail {
+class EventAwaitable;
+class EventTimedAwaitable;
+} // namespace detail
+
+/**
+ * Request to wait for the Event, should be co_await(ed).
+ */
+struct EventWait {
+    Event& event;
+};
+
+/**
+ * Request to wait for the Event no longer than till the timeout, see Event::waitFor().
+ */
+struct EventWaitFor {
+    Event& event;
+    Deadline timeout;
+};
+
+/**
+ * Asynchronous manual reset event.
+ * Example usage: `co_await event.wait();` in the waiting coroutines and `event.set();` in the signaling one.
+ * Once set the event stays signaled and releases all current and future waiters till it is reset.
+ * Unlike the Latch the event does not allocate and can be reused. Waiting on the set event is a single atomic load,
+ * set() releases all queued waiters with a single batched schedule per executor. Queued waiter is woken up early
+ * and removed from the queue in O(1) when its task is stopped or its deadline expires.
+ */
+class Event {
+public:
+    explicit Event(bool set = false)
+        : _set(set) {}
+
+    ~Event() {
+        if (!_waiters.empty()) {
+            std::abort();
+        }
+    }
+
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+
+public:
+    EventWait wait() {
+        return EventWait {*this};
+    }
+
+    /// `bool set = co_await event.waitFor(100ms);` is false if the timeout has expired first.
+    template <typename Rep, typename Period>
+    EventWaitFor waitFor(std::chrono::duration<Rep, Period> timeout) {
+        return EventWaitFor {*this, detail::deadlineAfter(timeout)};
+    }
+
+    /// Signals the event resuming all waiting coroutines.
+    void set();
+
+    /// Clears the signal, so the subsequent waiters are suspended till the next set().
+    void reset() noexcept {
+        _set.store(false, std::memory_order_relaxed);
+    }
+
+    bool isSet() const noexcept {
+        return _set.load(std::memory_order_acquire);
+    }
+
+private:
+    friend detail::EventAwaitable;
+
+    /// Queues the awaiter, returns false if the event is already set or the awaiter was cancelled.
+    bool queue(detail::EventAwaitable* awaiter);
+
+    /// Removes the cancelled awaiter from the queue in O(1), returns false if it is not queued.
+    bool remove(detail::EventAwaitable* awaiter);
+
+private:
+    std::atomic<bool> _set;
+    detail::IntrusiveList<detail::EventAwaitable> _waiters;
+    std::mutex _mutex;
+};
+
+namespace detail {
+
+class EventAwaitable : public IntrusiveListNode<EventAwaitable> {
+protected:
+    friend await_ready_trait<EventWait>;
+    EventAwaitable(Event* event, const PromiseBase& promise, Deadline timeout = Deadline::max())
+        : _event(event)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline)
+        , _timeout(timeout) {}
+
+public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    EventAwaitable(EventAwaitable&& other) noexcept
+        : _event(other._event)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline)
+        , _timeout(other._timeout) {}
+
+    bool await_ready() noexcept {
+        _signaled = _event->isSet();
+        // expired deadline fails fast in await_resume(), expired timeout makes the timed wait a mere check
+        return _signaled || detail::deadlineExceeded(std::min(_deadline, _timeout));
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the awaiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, std::min(_deadline, _timeout));
+        return _event->queue(this);
+    }
+
+    void await_resume() {
+        _canceller.disarm();
+        _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
+        if (_stopToken.stopRequested()) {
+            return Result<void>::stopped();
+        }
+        if (detail::deadlineExceeded(_deadline)) {
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend Event;
+    friend WaitCanceller<EventAwaitable>;
+
+    void cancel() {
+        if (_event->remove(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+protected:
+    Event* _event;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    Deadline _timeout;
+    WaitCanceller<EventAwaitable> _canceller;
+    // Guarded by the event mutex while the awaiter is suspended
+    bool _signaled = false;
+    bool _cancelled = false;
+};
+
+/**
+ * Awaitable of Event::waitFor(), returns whether the event was set before the timeout expired.
+ */
+class EventTimedAwaitable : public EventAwaitable {
+private:
+    friend await_ready_trait<EventWaitFor>;
+    EventTimedAwaitable(Event* event, const PromiseBase& promise, Deadline timeout)
+        : EventAwaitable(event, promise, timeout) {}
+
+public:
+    EventTimedAwaitable(EventTimedAwaitable&&) noexcept = default;
+
+    bool await_resume() {
+        EventAwaitable::await_resume();
+        return _signaled;
+    }
+
+    Result<bool> await_resume_result() {
+        auto result = EventAwaitable::await_resume_result();
+        if (result.isStopped()) {
+            return Result<bool>::stopped();
+        }
+        if (result.hasError()) {
+            return Result<bool> {result.error()};
+        }
+        return Result<bool> {_signaled};
+    }
+};
+
+} // namespace detail
+
+inline void Event::set() {
+    if (_set.load(std::memory_order_acquire)) {
+        return;
+    }
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _set.store(true, std::memory_order_release);
+        while (auto* waiter = _waiters.popFront()) {
+            waiter->_signaled = true;
+            wakeList.push(waiter->_executor, waiter->_continuation);
+        }
+    }
+    wakeList.schedule();
+}
+
+inline bool Event::queue(detail::EventAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (awaiter->_cancelled) {
+        return false;
+    }
+    if (_set.load(std::memory_order_relaxed)) {
+        awaiter->_signaled = true;
+        return false;
+    }
+    // Not registered with executor->external(), the awaiter is resumed exactly once, either by the set() or by its
+    // own cancellation.
+    _waiters.pushBack(awaiter);
+    return true;
+}
+
+inline bool Event::remove(detail::EventAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (!awaiter->linked()) {
+        // either already signaled, or cancelled before being queued
+        awaiter->_cancelled = !awaiter->_signaled;
+        return false;
+    }
+    _waiters.remove(awaiter);
+    return true;
+}
+
+template <>
+struct await_ready_trait<EventWait> {
+    static detail::EventAwaitable await_transform(const PromiseBase& promise, EventWait request) {
+        return detail::EventAwaitable {&request.event, promise};
+    }
+};
+
+template <>
+struct await_ready_trait<EventWaitFor> {
+    static detail::EventTimedAwaitable await_transform(const PromiseBase& promise, EventWaitFor request) {
+        return detail::EventTimedAwaitable {&request.event, promise, request.timeout};
+    }
+};
+
+} // namespace coro
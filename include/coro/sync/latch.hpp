@@ -1,24 +1,43 @@
 #pragma once
 
+#include "../core/deadline.hpp"
 #include "../core/executor.hpp"
 #include "../core/promise_base.hpp"
+#include "../core/result.hpp"
 #include "../core/traits.hpp"
 
 #include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <mutex>
 
 namespace coro {
 
+class Latch;
 namespace detail {
 class LatchAwaitable;
+class LatchTimedAwaitable;
 class LatchState;
 using LatchStateRef = std::shared_ptr<LatchState>;
 } // namespace detail
 
+/**
+ * Request to wait for the Latch no longer than till the timeout, see Latch::waitFor().
+ */
+struct LatchWaitFor {
+    const Latch& latch;
+    Deadline timeout;
+};
+
 /**
  * @brief A synchronization primitive that allows coroutines to wait until a specified count of events
  * has occurred. Once the count reaches zero, all coroutines waiting on the latch are resumed.
+ * Waiting coroutine is woken up early and removed from the queue in O(1) when its task is stopped or its deadline
+ * expires.
  *
  * @code
  * // coroutine 0
@@ -39,6 +58,15 @@ public:
      */
     void count_down(std::ptrdiff_t n = 1);
 
+    /**
+     * @brief Waits for the latch no longer than the given duration.
+     *        `bool signaled = co_await latch.waitFor(100ms);` is false if the timeout has expired first.
+     */
+    template <typename Rep, typename Period>
+    LatchWaitFor waitFor(std::chrono::duration<Rep, Period> timeout) const {
+        return LatchWaitFor {*this, detail::deadlineAfter(timeout)};
+    }
+
 private:
     friend class detail::LatchAwaitable;
     const detail::LatchStateRef& state() const {
@@ -65,79 +93,160 @@ public:
         return _count <= 0;
     }
 
-    bool queue(detail::LatchAwaitable* awaitable) {
-        std::scoped_lock lock {_mutex};
-        if (_count <= 0) {
-            return false;
-        }
-        _awaiters.pushBack(awaitable);
-        return true;
-    }
+    /// Queues the awaiter, returns false if the latch is already signaled or the awaiter was cancelled.
+    bool queue(detail::LatchAwaitable* awaitable);
 
-    void remove(const detail::LatchAwaitable* awaitable) {
-        std::scoped_lock lock {_mutex};
-        _awaiters.erase(awaitable);
-    }
+    /// Removes the cancelled awaiter from the queue in O(1), returns false if it is not queued.
+    bool remove(detail::LatchAwaitable* awaitable);
 
 private:
     std::ptrdiff_t _count;
-    detail::Deque<detail::LatchAwaitable*> _awaiters;
+    detail::IntrusiveList<detail::LatchAwaitable> _awaiters;
     mutable std::mutex _mutex;
 };
 
-class LatchAwaitable {
-private:
+class LatchAwaitable : public IntrusiveListNode<LatchAwaitable> {
+protected:
     friend await_ready_trait<Latch>;
-    LatchAwaitable(const Latch& latch, const PromiseBase& promise)
+    LatchAwaitable(const Latch& latch, const PromiseBase& promise, Deadline timeout = Deadline::max())
         : _state(latch._state)
-        , _executor(promise.executor)
-        , _stopToken(promise.context.stopToken) {}
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline)
+        , _timeout(timeout) {}
 
 public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    LatchAwaitable(LatchAwaitable&& other) noexcept
+        : _state(std::move(other._state))
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline)
+        , _timeout(other._timeout) {}
+
     bool await_ready() noexcept {
-        return _state->signaled();
+        _signaled = _state->signaled();
+        // expired deadline fails fast in await_resume(), expired timeout makes the timed wait a mere check
+        return _signaled || detail::deadlineExceeded(std::min(_deadline, _timeout));
     }
 
     template <typename Promise>
-    bool await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
         _continuation = CoroHandle::fromTypedHandle(continuation);
-        const bool queued = _state->queue(this);
-        if (queued) {
-            _executor->external(_continuation);
-        }
-        return queued;
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the awaiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, std::min(_deadline, _timeout));
+        return _state->queue(this);
     }
 
     void await_resume() {
+        _canceller.disarm();
+        _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
         if (_stopToken.stopRequested()) {
-            _state->remove(this);
-            _stopToken.throwException();
+            return Result<void>::stopped();
+        }
+        if (detail::deadlineExceeded(_deadline)) {
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
         }
+        return Result<void> {};
     }
 
 private:
     friend class LatchState;
-    void latchSignaled() {
-        _executor->schedule(_continuation);
+    friend WaitCanceller<LatchAwaitable>;
+
+    void cancel() {
+        if (_state->remove(this)) {
+            _executor->schedule(_continuation);
+        }
     }
 
-private:
+protected:
     LatchState::Ref _state;
-    Executor::Ref _executor;
+    Executor* _executor;
     CoroHandle _continuation;
     StopToken _stopToken;
+    Deadline _deadline;
+    Deadline _timeout;
+    WaitCanceller<LatchAwaitable> _canceller;
+    // Guarded by the latch mutex while the awaiter is suspended
+    bool _signaled = false;
+    bool _cancelled = false;
 };
 
-inline void LatchState::count_down(std::ptrdiff_t n) {
+/**
+ * Awaitable of Latch::waitFor(), returns whether the latch was signaled before the timeout expired.
+ */
+class LatchTimedAwaitable : public LatchAwaitable {
+private:
+    friend await_ready_trait<LatchWaitFor>;
+    LatchTimedAwaitable(const Latch& latch, const PromiseBase& promise, Deadline timeout)
+        : LatchAwaitable(latch, promise, timeout) {}
+
+public:
+    LatchTimedAwaitable(LatchTimedAwaitable&&) noexcept = default;
+
+    bool await_resume() {
+        LatchAwaitable::await_resume();
+        return _signaled;
+    }
+
+    Result<bool> await_resume_result() {
+        auto result = LatchAwaitable::await_resume_result();
+        if (result.isStopped()) {
+            return Result<bool>::stopped();
+        }
+        if (result.hasError()) {
+            return Result<bool> {result.error()};
+        }
+        return Result<bool> {_signaled};
+    }
+};
+
+inline bool LatchState::queue(detail::LatchAwaitable* awaitable) {
     std::scoped_lock lock {_mutex};
-    _count -= n;
+    if (awaitable->_cancelled) {
+        return false;
+    }
     if (_count <= 0) {
-        while (true) {
-            auto next = _awaiters.popFront().value_or(nullptr);
-            if (!next) break;
-            next->latchSignaled();
+        awaitable->_signaled = true;
+        return false;
+    }
+    // Not registered with executor->external(), the awaiter is resumed exactly once, either by the count_down() or
+    // by its own cancellation.
+    _awaiters.pushBack(awaitable);
+    return true;
+}
+
+inline bool LatchState::remove(detail::LatchAwaitable* awaitable) {
+    std::scoped_lock lock {_mutex};
+    if (!awaitable->linked()) {
+        // either already signaled, or cancelled before being queued
+        awaitable->_cancelled = !awaitable->_signaled;
+        return false;
+    }
+    _awaiters.remove(awaitable);
+    return true;
+}
+
+inline void LatchState::count_down(std::ptrdiff_t n) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _count -= n;
+        if (_count <= 0) {
+            while (auto* next = _awaiters.popFront()) {
+                next->_signaled = true;
+                wakeList.push(next->_executor, next->_continuation);
+            }
         }
     }
+    wakeList.schedule();
 }
 
 } // namespace detail
@@ -153,4 +262,11 @@ struct await_ready_trait<Latch> {
     }
 };
 
+template <>
+struct await_ready_trait<LatchWaitFor> {
+    static detail::LatchTimedAwaitable await_transform(const PromiseBase& promise, LatchWaitFor request) {
+        return detail::LatchTimedAwaitable {request.latch, promise, request.timeout};
+    }
+};
+
 } // namespace coro
@@ -1,49 +1,106 @@
 #pragma once
 
+#include "../core/deadline.hpp"
 #include "../core/executor.hpp"
 #include "../core/promise_base.hpp"
+#include "../core/result.hpp"
 #include "../core/traits.hpp"
 #include "../detail/containers.hpp"
 #include "../detail/utils.hpp"
+#include "../detail/wait_canceller.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
 
 namespace coro {
 
+class Mutex;
 class ScopedLock;
 namespace detail {
 class MutexAwaitable;
-}
+class MutexTimedAwaitable;
+} // namespace detail
+
+/**
+ * Request to lock the Mutex waiting no longer than till the timeout, see Mutex::lockFor().
+ */
+struct MutexLockFor {
+    Mutex& mutex;
+    Deadline timeout;
+};
 
 /**
- * Asynchronous mutex working on the first come first served basis.
+ * Asynchronous mutex.
  * Example usage: `auto lock = co_await mutex;`
  * co_await-ing to the mutex will return ScopedLock, which will unlock
  * the mutex when goes out of the scope.
- * When one coroutine has the lock all subsequent coroutines requesting the lock
- * will be suspended and queued. When the lock is released the next queued
- * coroutine will be given then lock and resumed on its executor.
+ * Uncontended lock and unlock are a single atomic operation, suspended coroutines are queued in the intrusive list
+ * of the awaiters, so queueing does not allocate either. Queued coroutine is woken up early and removed from the queue
+ * in O(1) when its task is stopped or its deadline expires. The mutex works in one of the two modes:
+ * - Mode::Fifo (default) works on the first come first served basis. When the lock is released the next queued
+ *   coroutine is given the lock and resumed on its executor.
+ * - Mode::Barging trades fairness for throughput. Running coroutines take the free lock regardless of the queued
+ *   ones, and unlock releases the lock before waking the queue up, so the running ones can take it first. The first
+ *   queued coroutine then retries the lock on the unlocking thread and stays parked at the front if it loses, so it
+ *   is woken up only with the lock taken on its behalf. Neither mode allocates on the contended path.
  */
 class Mutex {
 public:
-    Mutex() = default;
+    enum class Mode {
+        Fifo,
+        Barging,
+    };
+
+    explicit Mutex(Mode mode = Mode::Fifo)
+        : _mode(mode) {}
 
     ~Mutex() {
-        if (!_awaiters.empty()) {
+        if (!_waiters.empty()) {
             std::abort();
         }
     }
 
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+public:
+    Mode mode() const noexcept {
+        return _mode;
+    }
+
+    /**
+     * Locks the mutex waiting no longer than the given duration.
+     * `std::optional<ScopedLock> lock = co_await mutex.lockFor(100ms);` is empty if the timeout has expired first.
+     * The waiting awaiter is removed from the queue in O(1) on timeout, the same as on stop or on the task deadline.
+     */
+    template <typename Rep, typename Period>
+    MutexLockFor lockFor(std::chrono::duration<Rep, Period> timeout) {
+        return MutexLockFor {*this, detail::deadlineAfter(timeout)};
+    }
+
 private:
     friend detail::MutexAwaitable;
+    friend detail::MutexTimedAwaitable;
     friend ScopedLock;
 
-    /// Try to lock the mutex and return whether the attempt was sucessfull
-    bool try_lock() {
-        std::scoped_lock lock {_mutex};
-        if (_locked) return false;
-        _locked = true;
-        return true;
+    /// Try to lock the mutex and return whether the attempt was sucessfull.
+    /// In the Fifo mode the attempt fails while there are queued awaiters, so newcomers do not overtake them.
+    bool try_lock() noexcept {
+        const uint32_t busy = _mode == Mode::Fifo ? LockedBit | WaitersBit : LockedBit;
+        uint32_t state = _state.load(std::memory_order_relaxed);
+        while (!(state & busy)) {
+            if (_state.compare_exchange_weak(
+                    state, state | LockedBit, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
     }
 
     /// Unlock mutex allowing next queued or incoming awaiter to lock it.
@@ -51,25 +108,43 @@ private:
 
     /// Lock mutex if it is not currenlty locked, queue awaiter otherwise
     /// returns true if lock didn't succeed and awaiter was queued, false otherwise.
-    bool lock_or_queue(detail::MutexAwaitable* awaiter) {
-        std::scoped_lock lock {_mutex};
-        if (!_locked) {
-            _locked = true;
-            return false;
-        }
-        _awaiters.push(awaiter);
-        return true;
-    }
+    bool lock_or_queue(detail::MutexAwaitable* awaiter);
+
+    /// Appends the already suspended awaiters to the queue under a single lock, and locks the mutex for the first of
+    /// them if it is free. Returns the awaiter the lock was taken for, which should be woken up via wake().
+    detail::MutexAwaitable* queueAll(detail::IntrusiveList<detail::MutexAwaitable>& awaiters);
+
+    /// Remove the cancelled awaiter from the queue, returns false if it is not queued.
+    bool remove(detail::MutexAwaitable* awaiter);
+
+    /// Releases the lock, or hands it over to the first queued awaiter, which is returned then.
+    /// In the Barging mode the lock is released first and retried on behalf of the first queued awaiter, which stays
+    /// at the front if the running coroutine takes the lock first, and is retried on the next unlock.
+    detail::MutexAwaitable* handOver();
+
+    /// Wakes up the dequeued awaiter, which owns the lock already, should be called without holding the mutex.
+    /// The awaiters which give the lock back via their _onGranted are skipped, and the lock is handed over to the next
+    /// one in a loop, so a long chain of them does not grow the stack.
+    void wake(detail::MutexAwaitable* awaiter);
+
+    /// Dequeues the first awaiter, should be called under the mutex.
+    detail::MutexAwaitable* popWaiter() noexcept;
 
 private:
-    detail::Queue<detail::MutexAwaitable*> _awaiters;
+    // Lock free fast paths work only while the waiters bit is clear, which is changed only under the mutex.
+    static constexpr uint32_t LockedBit = 1;
+    static constexpr uint32_t WaitersBit = 2;
+
+    std::atomic<uint32_t> _state = 0;
+    detail::IntrusiveList<detail::MutexAwaitable> _waiters;
     mutable std::mutex _mutex;
-    bool _locked = false;
+    const Mode _mode;
 };
 
 class ScopedLock {
 private:
     friend detail::MutexAwaitable;
+    friend detail::MutexTimedAwaitable;
     ScopedLock(Mutex* mutex)
         : _mutex(mutex) {}
 
@@ -77,14 +152,28 @@ public:
     // Move only
     ScopedLock(const ScopedLock&) = delete;
     ScopedLock& operator=(const ScopedLock&) = delete;
-    ScopedLock(ScopedLock&&) = default;
-    ScopedLock& operator=(ScopedLock&&) = default;
+
+    ScopedLock(ScopedLock&& other) noexcept
+        : _mutex(std::exchange(other._mutex, nullptr)) {}
+
+    ScopedLock& operator=(ScopedLock&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _mutex = std::exchange(other._mutex, nullptr);
+        }
+        return *this;
+    }
 
 public:
     ~ScopedLock() {
         reset();
     }
 
+    /// Returns the locked mutex, or nullptr if the lock was released or moved from.
+    Mutex* mutex() const noexcept {
+        return _mutex;
+    }
+
     void reset() {
         if (_mutex) {
             _mutex->unlock();
@@ -98,61 +187,297 @@ private:
 
 namespace detail {
 
-class MutexAwaitable {
-private:
+class MutexAwaitable : public IntrusiveListNode<MutexAwaitable> {
+protected:
     friend await_ready_trait<Mutex>;
 
-    MutexAwaitable(Mutex* mutex, const PromiseBase& promise)
+    MutexAwaitable(Mutex* mutex, const PromiseBase& promise, Deadline timeout = Deadline::max())
         : _mutex(mutex)
-        , _executor(promise.executor)
-        , _stopToken(promise.context.stopToken) {}
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline)
+        , _timeout(timeout) {}
 
 public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    MutexAwaitable(MutexAwaitable&& other) noexcept
+        : _mutex(other._mutex)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline)
+        , _timeout(other._timeout) {}
+
     bool await_ready() noexcept {
-        return _mutex->try_lock();
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without locking
+            return true;
+        }
+        _granted = _mutex->try_lock();
+        // expired timeout makes the timed lock a mere attempt
+        return _granted || detail::deadlineExceeded(_timeout);
     }
 
     template <typename Promise>
-    bool await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
         _continuation = CoroHandle::fromTypedHandle(continuation);
-        const bool queued = _mutex->lock_or_queue(this);
-        if (queued) {
-            _executor->external(_continuation);
-        }
-        return queued;
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the awaiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, waitDeadline());
+        return _mutex->lock_or_queue(this);
     }
 
     ScopedLock await_resume() {
+        if (!acquired()) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
         ScopedLock lock {_mutex};
         _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
         return lock;
     }
 
+    Result<ScopedLock> await_resume_result() {
+        const bool locked = acquired();
+        std::optional<ScopedLock> lock;
+        if (locked) {
+            lock.emplace(ScopedLock {_mutex});
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<ScopedLock>::stopped();
+        }
+        if (!locked || detail::deadlineExceeded(_deadline)) {
+            return Result<ScopedLock> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<ScopedLock> {std::move(*lock)};
+    }
+
+protected:
+    /// Called on the thread handing the lock over to the queued awaiter before resuming it, lets the derived
+    /// awaitables, e.g. the ConditionVariable one, decide what to do with the lock. Returns true if the awaiter gives
+    /// the lock back and should not be resumed.
+    using OnGranted = bool (*)(MutexAwaitable* awaiter);
+
+    /// Takes the mutex over from the lock without unlocking it.
+    static Mutex* release(ScopedLock& lock) noexcept {
+        return std::exchange(lock._mutex, nullptr);
+    }
+
+    /// Wraps the mutex locked for the awaiter into the lock.
+    static ScopedLock adopt(Mutex* mutex) noexcept {
+        return ScopedLock {mutex};
+    }
+
+    /// Queues the already suspended awaiters of the same mutex at once, they are resumed when the lock is handed over
+    /// to them, the same as the awaiters queued by co_await.
+    static void queueAll(Mutex* mutex, IntrusiveList<MutexAwaitable>& awaiters) {
+        if (auto* awaiter = mutex->queueAll(awaiters)) {
+            mutex->wake(awaiter);
+        }
+    }
+
+    void unlockMutex() {
+        _mutex->unlock();
+    }
+
+    /// Returns whether the mutex is locked for this awaiter, which is resumed either by the unlock or by the
+    /// cancellation, the latter has already removed it from the queue.
+    bool acquired() {
+        _canceller.disarm();
+        return _granted;
+    }
+
+    Deadline waitDeadline() const noexcept {
+        return std::min(_deadline, _timeout);
+    }
+
 private:
     friend class ::coro::Mutex;
-    void mutex_available() {
-        _executor->schedule(_continuation);
+    friend WaitCanceller<MutexAwaitable>;
+
+    void cancel() {
+        if (_mutex->remove(this)) {
+            _executor->schedule(_continuation);
+        }
     }
 
-private:
+protected:
     Mutex* _mutex;
-    Executor::Ref _executor;
+    Executor* _executor;
     CoroHandle _continuation;
     StopToken _stopToken;
+    Deadline _deadline;
+    Deadline _timeout;
+    WaitCanceller<MutexAwaitable> _canceller;
+    OnGranted _onGranted = nullptr;
+    // Guarded by the mutex while the awaiter is suspended
+    bool _granted = false;
+    bool _cancelled = false;
+};
+
+/**
+ * Awaitable of Mutex::lockFor(), returns std::nullopt when the timeout expires before the lock is acquired.
+ */
+class MutexTimedAwaitable : public MutexAwaitable {
+private:
+    friend await_ready_trait<MutexLockFor>;
+
+    MutexTimedAwaitable(Mutex* mutex, const PromiseBase& promise, Deadline timeout)
+        : MutexAwaitable(mutex, promise, timeout) {}
+
+public:
+    MutexTimedAwaitable(MutexTimedAwaitable&&) noexcept = default;
+
+    std::optional<ScopedLock> await_resume() {
+        std::optional<ScopedLock> lock;
+        if (acquired()) {
+            lock.emplace(ScopedLock {_mutex});
+        }
+        _stopToken.throwIfStopped();
+        detail::throwIfDeadlineExceeded(_deadline);
+        return lock;
+    }
+
+    Result<std::optional<ScopedLock>> await_resume_result() {
+        std::optional<ScopedLock> lock;
+        if (acquired()) {
+            lock.emplace(ScopedLock {_mutex});
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<std::optional<ScopedLock>>::stopped();
+        }
+        if (detail::deadlineExceeded(_deadline)) {
+            return Result<std::optional<ScopedLock>> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<std::optional<ScopedLock>> {std::move(lock)};
+    }
 };
 
 } // namespace detail
 
+inline bool Mutex::lock_or_queue(detail::MutexAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (awaiter->_cancelled) {
+        return false;
+    }
+    if (_waiters.empty()) {
+        // Once the bit is set the lock is released only under the mutex in the Fifo mode, so it can be safely checked
+        // once more. In the Barging mode it can still be taken by the running coroutines, so it is retried instead.
+        const uint32_t state = _state.fetch_or(WaitersBit, std::memory_order_acq_rel);
+        if (_mode == Mode::Fifo && !(state & LockedBit)) {
+            _state.exchange(LockedBit, std::memory_order_acquire);
+            awaiter->_granted = true;
+            return false;
+        }
+        if (_mode == Mode::Barging && try_lock()) {
+            _state.fetch_and(~WaitersBit, std::memory_order_relaxed);
+            awaiter->_granted = true;
+            return false;
+        }
+    }
+    // Not registered with executor->external(), the awaiter is resumed exactly once, either by the unlock() or by
+    // its own cancellation.
+    _waiters.pushBack(awaiter);
+    return true;
+}
+
+inline bool Mutex::remove(detail::MutexAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (!awaiter->linked()) {
+        // either already granted, or cancelled before being queued
+        awaiter->_cancelled = !awaiter->_granted;
+        return false;
+    }
+    _waiters.remove(awaiter);
+    if (_waiters.empty()) {
+        _state.fetch_and(~WaitersBit, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+inline detail::MutexAwaitable* Mutex::queueAll(detail::IntrusiveList<detail::MutexAwaitable>& awaiters) {
+    std::scoped_lock lock {_mutex};
+    if (!_waiters.empty()) {
+        // the lock is held, or retried by the unlock in the Barging mode, and is handed over to the queue in order
+        _waiters.append(awaiters);
+        return nullptr;
+    }
+    _waiters.append(awaiters);
+    if (_waiters.empty()) {
+        return nullptr;
+    }
+    // Once the bit is set the lock is released only under the mutex in the Fifo mode, so it can be taken as is.
+    const uint32_t state = _state.fetch_or(WaitersBit, std::memory_order_acq_rel);
+    if (_mode == Mode::Fifo && !(state & LockedBit)) {
+        _state.fetch_or(LockedBit, std::memory_order_acquire);
+        return popWaiter();
+    }
+    if (_mode == Mode::Barging && try_lock()) {
+        return popWaiter();
+    }
+    return nullptr;
+}
+
 inline void Mutex::unlock() {
+    if (auto* waiter = handOver()) {
+        wake(waiter);
+    }
+}
+
+inline detail::MutexAwaitable* Mutex::handOver() {
+    if (_mode == Mode::Barging) {
+        const uint32_t state = _state.fetch_and(~LockedBit, std::memory_order_release);
+        if (!(state & WaitersBit)) {
+            return nullptr;
+        }
+        std::scoped_lock lock {_mutex};
+        if (_waiters.empty() || !try_lock()) {
+            // either the queue was emptied by the cancellation, or the lock was taken by the running coroutine, whose
+            // unlock retries it again
+            return nullptr;
+        }
+        return popWaiter();
+    }
+    uint32_t state = LockedBit;
+    if (_state.compare_exchange_strong(state, 0, std::memory_order_release, std::memory_order_relaxed)) {
+        return nullptr;
+    }
     std::scoped_lock lock {_mutex};
-    auto* awaiter = _awaiters.pop().value_or(nullptr);
-    if (awaiter) {
-        // since this is a first come first serve mutex
-        // if there is an awaiter in the queue pass lock to it without unlocking
-        awaiter->mutex_available();
-    } else {
-        _locked = false;
+    // since this is a first come first serve mutex
+    // pass the lock to the first awaiter without unlocking
+    auto* waiter = popWaiter();
+    if (!waiter) {
+        _state.fetch_and(~(LockedBit | WaitersBit), std::memory_order_release);
+    }
+    return waiter;
+}
+
+inline void Mutex::wake(detail::MutexAwaitable* waiter) {
+    while (waiter->_onGranted && waiter->_onGranted(waiter)) {
+        // The awaiter has given the lock back and must not be touched anymore, as it might be granted and resumed
+        // again by another thread.
+        waiter = handOver();
+        if (!waiter) {
+            return;
+        }
+    }
+    // The dequeued awaiter is resumed only by this wake up, its cancellation finds it granted and does nothing.
+    // Keep executor alive while scheduling, since resumed awaiter can release the last reference to it.
+    Executor::TaskRef executor = waiter->_executor;
+    CoroHandle continuation = waiter->_continuation;
+    // Scheduled via next(), since the awaiter owns the lock already and should run as soon as possible.
+    executor->next(std::move(continuation));
+}
+
+inline detail::MutexAwaitable* Mutex::popWaiter() noexcept {
+    auto* waiter = _waiters.popFront();
+    if (waiter) {
+        if (_waiters.empty()) {
+            _state.fetch_and(~WaitersBit, std::memory_order_relaxed);
+        }
+        waiter->_granted = true;
     }
+    return waiter;
 }
 
 template <>
@@ -162,4 +487,11 @@ struct await_ready_trait<Mutex> {
     }
 };
 
+template <>
+struct await_ready_trait<MutexLockFor> {
+    static detail::MutexTimedAwaitable await_transform(const PromiseBase& promise, MutexLockFor request) {
+        return detail::MutexTimedAwaitable {&request.mutex, promise, request.timeout};
+    }
+};
+
 } // namespace coro
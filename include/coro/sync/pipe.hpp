@@ -1,138 +1,795 @@
 #pragma once
 
+#include "../core/deadline.hpp"
 #include "../core/executor.hpp"
 #include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/task.hpp"
 #include "../core/traits.hpp"
 #include "../detail/containers.hpp"
+#include "../detail/select_claim.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
 
+#include <algorithm>
 #include <coroutine>
-#include <queue>
+#include <cstdlib>
+#include <limits>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace coro {
 
 template <typename T>
 class PipeDataReader;
 
+template <typename T>
+class PipeDataWriter;
+
+template <typename T>
+class PipeBatchReader;
+
+template <typename T>
+class PipeNextReader;
+
 template <typename T>
 class PipeDataAwaitable;
 
+template <typename T>
+class PipeBatchAwaitable;
+
+template <typename T>
+class PipeNextAwaitable;
+
+template <typename T>
+class PipeWriteAwaitable;
+
+namespace detail {
+template <typename T>
+class PipeReaderNode;
+
+template <typename T>
+class PipeSelectBranch;
+} // namespace detail
+
+/**
+ * Thrown by the reads of the closed and drained pipe, and by the writes into the closed pipe.
+ */
+class PipeClosed : public std::runtime_error {
+public:
+    PipeClosed()
+        : std::runtime_error("Pipe has been closed.") {}
+};
+
 /**
  * @brief Asynchronous pipe providing means to implement multiple producer multiple consumer pattern.
  * Unlike standard posix pipe, user read writes objects of type T rather then raw bytes.
- * There is no limitation on pipe size and write() is non blocking. Read is asynchronous so in order to read one has to
- * co_await for it.
+ * Read is asynchronous so in order to read one has to co_await for it. By default the pipe is unbounded and
+ * `co_await pipe.write(data)` never suspends. The pipe constructed with the capacity suspends the writers while it is
+ * full, so fast producers can not outrun the consumers. The capacity of zero makes a rendezvous pipe, where every
+ * writer waits for the reader. Non coroutine producers and consumers can use tryWrite() and tryRead() instead.
+ * Suspended readers and writers hand the data over directly, without passing it through the buffer. Suspended reader
+ * or writer is woken up early and removed from the queue in O(1) when its task is stopped or its deadline expires.
+ * Producer signals the end of the stream with close(), after which the consumers drain the buffered data and then
+ * get the end of the stream, e.g. `while (auto data = co_await pipe.next()) { ... }` or `co_await forEach(pipe, fn)`.
  */
 template <typename T>
 class Pipe {
 public:
-    Pipe() {}
+    static constexpr size_t Unbounded = std::numeric_limits<size_t>::max();
+
+    explicit Pipe(size_t capacity = Unbounded)
+        : _capacity(capacity) {}
+
+    ~Pipe() {
+        if (!_readers.empty() || !_writers.empty()) {
+            std::abort();
+        }
+    }
+
+    Pipe(const Pipe&) = delete;
+    Pipe& operator=(const Pipe&) = delete;
 
 public:
-    void write(T data);
+    /// Writes the data suspending while the pipe is full, should be co_await(ed).
+    [[nodiscard]] PipeDataWriter<T> write(T data) {
+        return PipeDataWriter<T> {*this, std::move(data)};
+    }
+
+    /// Writes the data if the pipe is not full, returns false without consuming the data otherwise.
+    bool tryWrite(T&& data);
+
+    bool tryWrite(const T& data) {
+        T copy = data;
+        return tryWrite(std::move(copy));
+    }
 
-    PipeDataReader<T> read() {
+    /// Moves the items into the pipe till it is full, under a single lock and with a single batched wake up of the
+    /// readers per executor. Returns the number of the written items, which are the prefix of the given ones.
+    [[nodiscard]] size_t writeMany(std::span<T> items);
+
+    /// Reads the data suspending while the pipe is empty, throws PipeClosed once the closed pipe is drained.
+    [[nodiscard]] PipeDataReader<T> read() {
         return PipeDataReader<T> {*this};
     }
 
-private:
-    friend PipeDataAwaitable<T>;
+    /// Same as read(), but results in std::nullopt instead of throwing at the end of the stream.
+    [[nodiscard]] PipeNextReader<T> next() {
+        return PipeNextReader<T> {*this};
+    }
 
-    std::optional<T> addReader(PipeDataAwaitable<T>* reader) {
-        std::scoped_lock lock {_mutex};
-        auto data = _data.pop();
-        if (data) {
-            return data;
-        } else {
-            _readers.push(reader);
-            return std::nullopt;
-        }
+    /// Reads up to maxCount available items at once, suspending till at least one is available, should be
+    /// co_await(ed) to get the std::vector<T> of the items. Results in the empty vector at the end of the stream.
+    [[nodiscard]] PipeBatchReader<T> readMany(size_t maxCount) {
+        return PipeBatchReader<T> {*this, maxCount};
     }
 
-    std::optional<T> readData() {
+    /// Reads the data if it is available without waiting.
+    std::optional<T> tryRead();
+
+    /// Ends the stream, all suspended readers of the empty pipe are resumed with the end of the stream and the
+    /// suspended writers with PipeClosed. Already buffered data can still be read. Writes fail after the close.
+    void close();
+
+    bool closed() const {
         std::scoped_lock lock {_mutex};
-        return _data.pop();
+        return _closed;
     }
 
+    size_t capacity() const noexcept {
+        return _capacity;
+    }
+
+private:
+    friend PipeDataAwaitable<T>;
+    friend PipeBatchAwaitable<T>;
+    friend PipeWriteAwaitable<T>;
+    friend detail::PipeSelectBranch<T>;
+
+    /// Passes the data to the first queued reader or into the buffer, returns false if the pipe is full.
+    /// Should be called under the mutex.
+    bool push(T& data, detail::WakeList& wakeList);
+
+    /// Takes the data from the buffer or from the first queued writer, should be called under the mutex.
+    std::optional<T> pop(detail::WakeList& wakeList);
+
+    /// Appends up to maxCount available items to the batch under a single lock.
+    void tryReadMany(std::vector<T>& batch, size_t maxCount);
+
+    /// Reads the data or queues the reader, returns true if the reader was queued.
+    bool readOrQueue(detail::PipeReaderNode<T>* reader);
+
+    /// Writes the data or queues the writer, returns true if the writer was queued.
+    bool writeOrQueue(PipeWriteAwaitable<T>* writer);
+
+    /// Removes the cancelled reader from the queue in O(1), returns false if it is not queued.
+    bool removeReader(detail::PipeReaderNode<T>* reader);
+
+    /// Removes the cancelled writer from the queue in O(1), returns false if it is not queued.
+    bool removeWriter(PipeWriteAwaitable<T>* writer);
+
 private:
+    const size_t _capacity;
     detail::Queue<T> _data;
-    detail::Queue<PipeDataAwaitable<T>*> _readers;
-    std::mutex _mutex;
+    detail::IntrusiveList<detail::PipeReaderNode<T>> _readers;
+    detail::IntrusiveList<PipeWriteAwaitable<T>> _writers;
+    bool _closed = false;
+    mutable std::mutex _mutex;
 };
 
+namespace detail {
+
+/**
+ * Queued reader of the Pipe, common for the single and the batch reads and for the pipe sources of coro::select().
+ * The writer hands a single item over to the queued reader directly. The reader belonging to the select gets the
+ * item only if it wins the claim of the select, otherwise it is skipped and left for the select to remove.
+ */
 template <typename T>
-class PipeDataAwaitable {
-public:
-    PipeDataAwaitable(PipeDataReader<T>&& reader, Executor::Ref executor)
-        : _pipe(reader._pipe)
-        , _executor(std::move(executor)) {}
+class PipeReaderNode : public IntrusiveListNode<PipeReaderNode<T>> {
+protected:
+    PipeReaderNode(Executor* executor)
+        : _executor(executor) {}
 
-    PipeDataAwaitable& operator co_await() {
-        _data = _pipe.readData();
-        return *this;
+    bool claim() {
+        return !_select || _select->claim();
     }
 
-    bool await_ready() noexcept {
+    /// Resumes the reader which got the data or the end of the stream.
+    void wake(WakeList& wakeList) {
+        if (!_select || _select->release()) {
+            wakeList.push(_executor, _continuation);
+        }
+    }
+
+    friend Pipe<T>;
+    // Guarded by the pipe mutex while the reader is suspended
+    std::optional<T> _data;
+    bool _closed = false;
+    bool _cancelled = false;
+    Executor* _executor;
+    CoroHandle _continuation;
+    SelectClaim* _select = nullptr;
+};
+
+} // namespace detail
+
+template <typename T>
+class PipeDataAwaitable : public detail::PipeReaderNode<T> {
+public:
+    PipeDataAwaitable(PipeDataReader<T>&& reader, const PromiseBase& promise)
+        : detail::PipeReaderNode<T>(promise.executor.get())
+        , _pipe(reader._pipe)
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    PipeDataAwaitable(PipeDataAwaitable&& other) noexcept
+        : detail::PipeReaderNode<T>(other._executor)
+        , _pipe(other._pipe)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast in await_resume() without consuming the data
+            return true;
+        }
+        _data = _pipe.tryRead();
         return _data.has_value();
     }
 
     template <typename Promise>
-    bool await_suspend(std::coroutine_handle<Promise> continuation) noexcept {
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
         _continuation = CoroHandle::fromTypedHandle(continuation);
-        auto data = _pipe.addReader(this);
-        if (data) {
-            _data = std::move(data);
-            return false;
-        }
-        return true;
+        // Armed before queueing, so the reader is never resumed while the callbacks are being registered.
+        // If the stop was already requested the reader is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _pipe.readOrQueue(this);
     }
 
     T await_resume() {
-        _continuation.throwIfStopped();
+        _canceller.disarm();
+        if (!_data) {
+            throwNotReceived();
+        }
         return std::move(_data).value();
     }
 
+    Result<T> await_resume_result() {
+        _canceller.disarm();
+        if (!_data) {
+            return failure<T>();
+        }
+        return Result<T> {std::move(_data).value()};
+    }
+
+protected:
+    [[noreturn]] void throwNotReceived() {
+        if (_closed) {
+            throw PipeClosed {};
+        }
+        _stopToken.throwIfStopped();
+        throw DeadlineExceeded {};
+    }
+
+    template <typename R>
+    Result<R> failure() {
+        if (_closed) {
+            return Result<R> {std::make_exception_ptr(PipeClosed {})};
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<R>::stopped();
+        }
+        return Result<R> {std::make_exception_ptr(DeadlineExceeded {})};
+    }
+
 private:
     friend Pipe<T>;
-    void dataAvailable(T&& data) {
-        _data = std::move(data);
-        _executor->schedule(_continuation);
+    friend detail::WaitCanceller<PipeDataAwaitable>;
+
+    void cancel() {
+        if (_pipe.removeReader(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+protected:
+    using detail::PipeReaderNode<T>::_data;
+    using detail::PipeReaderNode<T>::_closed;
+    using detail::PipeReaderNode<T>::_executor;
+    using detail::PipeReaderNode<T>::_continuation;
+
+    Pipe<T>& _pipe;
+    StopToken _stopToken;
+    Deadline _deadline;
+    detail::WaitCanceller<PipeDataAwaitable> _canceller;
+};
+
+/**
+ * Awaitable of Pipe::next(), results in std::nullopt at the end of the stream.
+ */
+template <typename T>
+class PipeNextAwaitable : public PipeDataAwaitable<T> {
+public:
+    PipeNextAwaitable(PipeNextReader<T>&& reader, const PromiseBase& promise)
+        : PipeDataAwaitable<T>(std::move(reader), promise) {}
+
+    std::optional<T> await_resume() {
+        this->_canceller.disarm();
+        if (!_data && !_closed) {
+            this->throwNotReceived();
+        }
+        return std::move(_data);
+    }
+
+    Result<std::optional<T>> await_resume_result() {
+        this->_canceller.disarm();
+        if (!_data && !_closed) {
+            return this->template failure<std::optional<T>>();
+        }
+        return Result<std::optional<T>> {std::move(_data)};
     }
 
 private:
+    using PipeDataAwaitable<T>::_data;
+    using PipeDataAwaitable<T>::_closed;
+};
+
+/**
+ * Awaitable of Pipe::readMany(), returns the batch of at least one item.
+ */
+template <typename T>
+class PipeBatchAwaitable : public detail::PipeReaderNode<T> {
+public:
+    PipeBatchAwaitable(PipeBatchReader<T>&& reader, const PromiseBase& promise)
+        : detail::PipeReaderNode<T>(promise.executor.get())
+        , _pipe(reader._pipe)
+        , _maxCount(std::max<size_t>(reader._maxCount, 1))
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    PipeBatchAwaitable(PipeBatchAwaitable&& other) noexcept
+        : detail::PipeReaderNode<T>(other._executor)
+        , _pipe(other._pipe)
+        , _maxCount(other._maxCount)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast in await_resume() without consuming the data
+            return true;
+        }
+        _pipe.tryReadMany(_batch, _maxCount);
+        return !_batch.empty();
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the reader is never resumed while the callbacks are being registered.
+        // If the stop was already requested the reader is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _pipe.readOrQueue(this);
+    }
+
+    std::vector<T> await_resume() {
+        _canceller.disarm();
+        if (!received() && !_closed) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        return std::move(_batch);
+    }
+
+    Result<std::vector<T>> await_resume_result() {
+        _canceller.disarm();
+        if (!received() && !_closed) {
+            if (_stopToken.stopRequested()) {
+                return Result<std::vector<T>>::stopped();
+            }
+            return Result<std::vector<T>> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<std::vector<T>> {std::move(_batch)};
+    }
+
+private:
+    /// The queued reader gets a single item from the writer, the rest of the batch is taken from the buffer.
+    bool received() {
+        if (_data) {
+            _batch.push_back(std::move(*_data));
+            _data.reset();
+            _pipe.tryReadMany(_batch, _maxCount);
+        }
+        return !_batch.empty();
+    }
+
+    friend Pipe<T>;
+    friend detail::WaitCanceller<PipeBatchAwaitable>;
+
+    void cancel() {
+        if (_pipe.removeReader(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    using detail::PipeReaderNode<T>::_data;
+    using detail::PipeReaderNode<T>::_closed;
+    using detail::PipeReaderNode<T>::_executor;
+    using detail::PipeReaderNode<T>::_continuation;
+
     Pipe<T>& _pipe;
-    std::optional<T> _data;
-    Executor::Ref _executor;
+    size_t _maxCount;
+    std::vector<T> _batch;
+    StopToken _stopToken;
+    Deadline _deadline;
+    detail::WaitCanceller<PipeBatchAwaitable> _canceller;
+};
+
+template <typename T>
+class PipeWriteAwaitable : public detail::IntrusiveListNode<PipeWriteAwaitable<T>> {
+public:
+    PipeWriteAwaitable(PipeDataWriter<T>&& writer, const PromiseBase& promise)
+        : _pipe(writer._pipe)
+        , _data(std::move(writer._data))
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    PipeWriteAwaitable(PipeWriteAwaitable&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : _pipe(other._pipe)
+        , _data(std::move(other._data))
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without writing
+            return true;
+        }
+        _written = _pipe.tryWrite(std::move(_data));
+        return _written;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the writer is never resumed while the callbacks are being registered.
+        // If the stop was already requested the writer is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _pipe.writeOrQueue(this);
+    }
+
+    /// Returns normally once the data is written, even if the task was stopped meanwhile.
+    void await_resume() {
+        _canceller.disarm();
+        if (!_written) {
+            if (_closed) {
+                throw PipeClosed {};
+            }
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
+        if (!_written) {
+            if (_closed) {
+                return Result<void> {std::make_exception_ptr(PipeClosed {})};
+            }
+            if (_stopToken.stopRequested()) {
+                return Result<void>::stopped();
+            }
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend Pipe<T>;
+    friend detail::WaitCanceller<PipeWriteAwaitable>;
+
+    void cancel() {
+        if (_pipe.removeWriter(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    Pipe<T>& _pipe;
+    // Taken by the reader under the pipe mutex while the writer is suspended
+    T _data;
+    bool _written = false;
+    bool _closed = false;
+    bool _cancelled = false;
+    Executor* _executor;
     CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    detail::WaitCanceller<PipeWriteAwaitable> _canceller;
 };
 
 template <typename T>
-void Pipe<T>::write(T data) {
-    std::scoped_lock lock {_mutex};
-    auto reader = _readers.pop().value_or(nullptr);
-    if (reader) {
-        reader->dataAvailable(std::move(data));
-    } else {
+bool Pipe<T>::tryWrite(T&& data) {
+    detail::WakeList wakeList;
+    bool written;
+    {
+        std::scoped_lock lock {_mutex};
+        written = push(data, wakeList);
+    }
+    wakeList.schedule();
+    return written;
+}
+
+template <typename T>
+size_t Pipe<T>::writeMany(std::span<T> items) {
+    detail::WakeList wakeList;
+    size_t written = 0;
+    {
+        std::scoped_lock lock {_mutex};
+        while (written < items.size() && push(items[written], wakeList)) {
+            ++written;
+        }
+    }
+    wakeList.schedule();
+    return written;
+}
+
+template <typename T>
+void Pipe<T>::tryReadMany(std::vector<T>& batch, size_t maxCount) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        while (batch.size() < maxCount) {
+            auto data = pop(wakeList);
+            if (!data) {
+                break;
+            }
+            batch.push_back(std::move(*data));
+        }
+    }
+    wakeList.schedule();
+}
+
+template <typename T>
+std::optional<T> Pipe<T>::tryRead() {
+    detail::WakeList wakeList;
+    std::optional<T> data;
+    {
+        std::scoped_lock lock {_mutex};
+        data = pop(wakeList);
+    }
+    wakeList.schedule();
+    return data;
+}
+
+template <typename T>
+bool Pipe<T>::push(T& data, detail::WakeList& wakeList) {
+    if (_closed) {
+        return false;
+    }
+    while (auto* reader = _readers.popFront()) {
+        if (!reader->claim()) {
+            // another source of the select has already completed it
+            continue;
+        }
+        // queued reader means the buffer is empty, so the data is handed over directly
+        reader->_data.emplace(std::move(data));
+        reader->wake(wakeList);
+        return true;
+    }
+    if (_data.size() < _capacity) {
         _data.push(std::move(data));
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+std::optional<T> Pipe<T>::pop(detail::WakeList& wakeList) {
+    auto data = _data.pop();
+    auto* writer = _writers.popFront();
+    if (!writer) {
+        return data;
+    }
+    writer->_written = true;
+    wakeList.push(writer->_executor, writer->_continuation);
+    if (!data) {
+        // rendezvous pipe, the data is handed over directly
+        return std::optional<T> {std::move(writer->_data)};
     }
+    // the buffer was full, the first queued writer takes the freed slot
+    _data.push(std::move(writer->_data));
+    return data;
 }
 
 template <typename T>
-class PipeDataReader {
+bool Pipe<T>::readOrQueue(detail::PipeReaderNode<T>* reader) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        if (reader->_cancelled) {
+            return false;
+        }
+        if (_data.empty() && _writers.empty() && !_closed) {
+            // Not registered with executor->external(), the reader is resumed exactly once, either by the writer or
+            // by its own cancellation.
+            _readers.pushBack(reader);
+            return true;
+        }
+        if (!reader->claim()) {
+            return false;
+        }
+        reader->_data = pop(wakeList);
+        // drained closed pipe, the end of the stream
+        reader->_closed = !reader->_data;
+    }
+    wakeList.schedule();
+    return false;
+}
+
+template <typename T>
+bool Pipe<T>::writeOrQueue(PipeWriteAwaitable<T>* writer) {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        if (writer->_cancelled) {
+            return false;
+        }
+        writer->_written = push(writer->_data, wakeList);
+        if (_closed) {
+            writer->_closed = true;
+            return false;
+        }
+        if (!writer->_written) {
+            _writers.pushBack(writer);
+            return true;
+        }
+    }
+    wakeList.schedule();
+    return false;
+}
+
+template <typename T>
+bool Pipe<T>::removeReader(detail::PipeReaderNode<T>* reader) {
+    std::scoped_lock lock {_mutex};
+    if (!reader->linked()) {
+        // either already received the data or the end of the stream, or cancelled before being queued
+        reader->_cancelled = !reader->_data.has_value() && !reader->_closed;
+        return false;
+    }
+    _readers.remove(reader);
+    return true;
+}
+
+template <typename T>
+void Pipe<T>::close() {
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _closed = true;
+        // queued readers mean the buffer is empty
+        while (auto* reader = _readers.popFront()) {
+            if (reader->claim()) {
+                reader->_closed = true;
+                reader->wake(wakeList);
+            }
+        }
+        while (auto* writer = _writers.popFront()) {
+            writer->_closed = true;
+            wakeList.push(writer->_executor, writer->_continuation);
+        }
+    }
+    wakeList.schedule();
+}
+
+template <typename T>
+bool Pipe<T>::removeWriter(PipeWriteAwaitable<T>* writer) {
+    std::scoped_lock lock {_mutex};
+    if (!writer->linked()) {
+        // either already written or failed by the close, or cancelled before being queued
+        writer->_cancelled = !writer->_written && !writer->_closed;
+        return false;
+    }
+    _writers.remove(writer);
+    return true;
+}
+
+template <typename T>
+class [[nodiscard]] PipeDataReader {
 public:
     PipeDataReader(Pipe<T>& pipe)
         : _pipe(pipe) {}
 
 private:
     friend class PipeDataAwaitable<T>;
+    friend class detail::PipeSelectBranch<T>;
+    Pipe<T>& _pipe;
+};
+
+template <typename T>
+class [[nodiscard]] PipeNextReader : public PipeDataReader<T> {
+public:
+    using PipeDataReader<T>::PipeDataReader;
+};
+
+template <typename T>
+class [[nodiscard]] PipeDataWriter {
+public:
+    PipeDataWriter(Pipe<T>& pipe, T&& data)
+        : _pipe(pipe)
+        , _data(std::move(data)) {}
+
+private:
+    friend class PipeWriteAwaitable<T>;
     Pipe<T>& _pipe;
+    T _data;
+};
+
+template <typename T>
+class [[nodiscard]] PipeBatchReader {
+public:
+    PipeBatchReader(Pipe<T>& pipe, size_t maxCount)
+        : _pipe(pipe)
+        , _maxCount(maxCount) {}
+
+private:
+    friend class PipeBatchAwaitable<T>;
+    Pipe<T>& _pipe;
+    size_t _maxCount;
 };
 
 template <typename T>
 struct await_ready_trait<PipeDataReader<T>> {
     static PipeDataAwaitable<T> await_transform(const PromiseBase& promise, PipeDataReader<T>&& awaitable) {
-        return PipeDataAwaitable<T> {std::move(awaitable), promise.executor};
+        return PipeDataAwaitable<T> {std::move(awaitable), promise};
     }
 };
 
+template <typename T>
+struct await_ready_trait<PipeNextReader<T>> {
+    static PipeNextAwaitable<T> await_transform(const PromiseBase& promise, PipeNextReader<T>&& awaitable) {
+        return PipeNextAwaitable<T> {std::move(awaitable), promise};
+    }
+};
+
+template <typename T>
+struct await_ready_trait<PipeBatchReader<T>> {
+    static PipeBatchAwaitable<T> await_transform(const PromiseBase& promise, PipeBatchReader<T>&& awaitable) {
+        return PipeBatchAwaitable<T> {std::move(awaitable), promise};
+    }
+};
+
+template <typename T>
+struct await_ready_trait<PipeDataWriter<T>> {
+    static PipeWriteAwaitable<T> await_transform(const PromiseBase& promise, PipeDataWriter<T>&& awaitable) {
+        return PipeWriteAwaitable<T> {std::move(awaitable), promise};
+    }
+};
+
+/**
+ * Calls the function for every item read from the pipe till the end of the stream.
+ * The function can be either a regular one, or return the Task which is co_await(ed) before reading the next item.
+ */
+template <typename T, typename Function>
+Task<void> forEach(Pipe<T>& pipe, Function function) {
+    while (auto data = co_await pipe.next()) {
+        if constexpr (std::is_void_v<std::invoke_result_t<Function&, T&&>>) {
+            function(std::move(*data));
+        } else {
+            co_await function(std::move(*data));
+        }
+    }
+}
+
 } // namespace coro
@@ -0,0 +1,464 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/ring_buffer.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+enum class RingPipeMode {
+    /// Single producer and single consumer, at most one writer and one reader at a time.
+    Spsc,
+    /// Multiple producers and multiple consumers.
+    Mpmc,
+};
+
+template <typename T, RingPipeMode Mode>
+class RingPipe;
+
+template <typename T, RingPipeMode Mode>
+class RingPipeReader;
+
+template <typename T, RingPipeMode Mode>
+class RingPipeWriter;
+
+namespace detail {
+template <typename T, RingPipeMode Mode>
+class RingPipeReadAwaitable;
+template <typename T, RingPipeMode Mode>
+class RingPipeWriteAwaitable;
+} // namespace detail
+
+/**
+ * @brief Bounded asynchronous pipe on top of the lock free ring buffer, for the high rate hops between executors.
+ * Has the same interface as the bounded coro::Pipe: `co_await pipe.write(data)`, `co_await pipe.read()`, tryWrite()
+ * and tryRead(). The capacity is rounded up to the power of two.
+ * Reads and writes are lock free while the ring is neither empty nor full, the lock is taken only to suspend the
+ * reader on the empty ring or the writer on the full one, and to wake them up. Suspended readers and writers are
+ * served in FIFO order, but unlike coro::Pipe the newcomers might overtake the suspended writers.
+ * The Spsc mode is faster, but allows only a single producer and a single consumer at a time.
+ */
+template <typename T, RingPipeMode Mode = RingPipeMode::Mpmc>
+class RingPipe {
+public:
+    explicit RingPipe(size_t capacity)
+        : _ring(capacity) {}
+
+    ~RingPipe() {
+        if (!_readers.empty() || !_writers.empty()) {
+            std::abort();
+        }
+    }
+
+    RingPipe(const RingPipe&) = delete;
+    RingPipe& operator=(const RingPipe&) = delete;
+
+public:
+    /// Writes the data suspending while the pipe is full, should be co_await(ed).
+    [[nodiscard]] RingPipeWriter<T, Mode> write(T data) {
+        return RingPipeWriter<T, Mode> {*this, std::move(data)};
+    }
+
+    /// Writes the data if the pipe is not full, returns false without consuming the data otherwise.
+    bool tryWrite(T&& data) {
+        if (!_ring.tryPush(data)) {
+            return false;
+        }
+        wakeWaiters(_waitingReaders);
+        return true;
+    }
+
+    bool tryWrite(const T& data) {
+        T copy = data;
+        return tryWrite(std::move(copy));
+    }
+
+    [[nodiscard]] RingPipeReader<T, Mode> read() {
+        return RingPipeReader<T, Mode> {*this};
+    }
+
+    /// Reads the data if it is available without waiting.
+    std::optional<T> tryRead() {
+        auto data = _ring.tryPop();
+        if (data) {
+            wakeWaiters(_waitingWriters);
+        }
+        return data;
+    }
+
+    size_t capacity() const noexcept {
+        return _ring.capacity();
+    }
+
+private:
+    using Ring = std::conditional_t<Mode == RingPipeMode::Spsc, detail::SpscRing<T>, detail::MpmcRing<T>>;
+    using ReadAwaitable = detail::RingPipeReadAwaitable<T, Mode>;
+    using WriteAwaitable = detail::RingPipeWriteAwaitable<T, Mode>;
+    friend ReadAwaitable;
+    friend WriteAwaitable;
+
+    /// Checks the waiters of the other side after the successful operation, which might have unblocked them.
+    /// The fence pairs with the one in readOrQueue() and writeOrQueue(): either the waiter sees the data or the free
+    /// slot when it retries after registering, or the operation sees the registered waiter here.
+    void wakeWaiters(const std::atomic<size_t>& waiting) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        detail::WakeList wakeList;
+        {
+            std::scoped_lock lock {_mutex};
+            transfer(wakeList);
+        }
+        wakeList.schedule();
+    }
+
+    /// Serves the suspended readers from the ring and moves the data of the suspended writers into it, till either
+    /// nobody is waiting or the ring is empty or full. Should be called under the mutex.
+    /// Suspended side is not running, so this does not break the single producer single consumer ring.
+    void transfer(detail::WakeList& wakeList);
+
+    /// Reads the data or queues the reader, returns true if the reader was queued.
+    bool readOrQueue(ReadAwaitable* reader);
+
+    /// Writes the data or queues the writer, returns true if the writer was queued.
+    bool writeOrQueue(WriteAwaitable* writer);
+
+    /// Removes the cancelled reader from the queue in O(1), returns false if it is not queued.
+    bool removeReader(ReadAwaitable* reader);
+
+    /// Removes the cancelled writer from the queue in O(1), returns false if it is not queued.
+    bool removeWriter(WriteAwaitable* writer);
+
+private:
+    Ring _ring;
+    // Number of the queued readers and writers, modified under the mutex and checked without it by the fast paths.
+    alignas(detail::CacheLineSize) std::atomic<size_t> _waitingReaders = 0;
+    std::atomic<size_t> _waitingWriters = 0;
+    detail::IntrusiveList<ReadAwaitable> _readers;
+    detail::IntrusiveList<WriteAwaitable> _writers;
+    std::mutex _mutex;
+};
+
+template <typename T>
+using SpscPipe = RingPipe<T, RingPipeMode::Spsc>;
+
+template <typename T>
+using MpmcPipe = RingPipe<T, RingPipeMode::Mpmc>;
+
+namespace detail {
+
+template <typename T, RingPipeMode Mode>
+class RingPipeReadAwaitable : public IntrusiveListNode<RingPipeReadAwaitable<T, Mode>> {
+public:
+    RingPipeReadAwaitable(RingPipe<T, Mode>* pipe, const PromiseBase& promise)
+        : _pipe(pipe)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    RingPipeReadAwaitable(RingPipeReadAwaitable&& other) noexcept
+        : _pipe(other._pipe)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast in await_resume() without consuming the data
+            return true;
+        }
+        _data = _pipe->tryRead();
+        return _data.has_value();
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the reader is never resumed while the callbacks are being registered.
+        // If the stop was already requested the reader is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _pipe->readOrQueue(this);
+    }
+
+    T await_resume() {
+        _canceller.disarm();
+        if (!_data) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        return std::move(_data).value();
+    }
+
+    Result<T> await_resume_result() {
+        _canceller.disarm();
+        if (!_data) {
+            if (_stopToken.stopRequested()) {
+                return Result<T>::stopped();
+            }
+            return Result<T> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<T> {std::move(_data).value()};
+    }
+
+private:
+    friend RingPipe<T, Mode>;
+    friend WaitCanceller<RingPipeReadAwaitable>;
+
+    void cancel() {
+        if (_pipe->removeReader(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    RingPipe<T, Mode>* _pipe;
+    // Guarded by the pipe mutex while the reader is suspended
+    std::optional<T> _data;
+    bool _cancelled = false;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<RingPipeReadAwaitable> _canceller;
+};
+
+template <typename T, RingPipeMode Mode>
+class RingPipeWriteAwaitable : public IntrusiveListNode<RingPipeWriteAwaitable<T, Mode>> {
+public:
+    RingPipeWriteAwaitable(RingPipe<T, Mode>* pipe, T&& data, const PromiseBase& promise)
+        : _pipe(pipe)
+        , _data(std::move(data))
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    RingPipeWriteAwaitable(RingPipeWriteAwaitable&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : _pipe(other._pipe)
+        , _data(std::move(other._data))
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without writing
+            return true;
+        }
+        _written = _pipe->tryWrite(std::move(_data));
+        return _written;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the writer is never resumed while the callbacks are being registered.
+        // If the stop was already requested the writer is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _pipe->writeOrQueue(this);
+    }
+
+    /// Returns normally once the data is written, even if the task was stopped meanwhile.
+    void await_resume() {
+        _canceller.disarm();
+        if (!_written) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+    }
+
+    Result<void> await_resume_result() {
+        _canceller.disarm();
+        if (!_written) {
+            if (_stopToken.stopRequested()) {
+                return Result<void>::stopped();
+            }
+            return Result<void> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<void> {};
+    }
+
+private:
+    friend RingPipe<T, Mode>;
+    friend WaitCanceller<RingPipeWriteAwaitable>;
+
+    void cancel() {
+        if (_pipe->removeWriter(this)) {
+            _executor->schedule(_continuation);
+        }
+    }
+
+private:
+    RingPipe<T, Mode>* _pipe;
+    // Moved into the ring under the pipe mutex while the writer is suspended
+    T _data;
+    bool _written = false;
+    bool _cancelled = false;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<RingPipeWriteAwaitable> _canceller;
+};
+
+} // namespace detail
+
+template <typename T, RingPipeMode Mode>
+void RingPipe<T, Mode>::transfer(detail::WakeList& wakeList) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        if (auto* reader = _readers.front()) {
+            if (auto data = _ring.tryPop()) {
+                _readers.popFront();
+                _waitingReaders.fetch_sub(1, std::memory_order_relaxed);
+                reader->_data = std::move(data);
+                wakeList.push(reader->_executor, reader->_continuation);
+                progress = true;
+            }
+        }
+        if (auto* writer = _writers.front()) {
+            if (_ring.tryPush(writer->_data)) {
+                _writers.popFront();
+                _waitingWriters.fetch_sub(1, std::memory_order_relaxed);
+                writer->_written = true;
+                wakeList.push(writer->_executor, writer->_continuation);
+                progress = true;
+            }
+        }
+    }
+}
+
+template <typename T, RingPipeMode Mode>
+bool RingPipe<T, Mode>::readOrQueue(ReadAwaitable* reader) {
+    detail::WakeList wakeList;
+    bool queued = true;
+    {
+        std::scoped_lock lock {_mutex};
+        if (reader->_cancelled) {
+            return false;
+        }
+        _waitingReaders.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_readers.empty() && (reader->_data = _ring.tryPop())) {
+            _waitingReaders.fetch_sub(1, std::memory_order_relaxed);
+            queued = false;
+        } else {
+            // Not registered with executor->external(), the reader is resumed exactly once, either by the writer or
+            // by its own cancellation.
+            _readers.pushBack(reader);
+        }
+        // the freed slot might unblock the writers, or the data might have arrived for the queued readers
+        transfer(wakeList);
+    }
+    wakeList.schedule();
+    return queued;
+}
+
+template <typename T, RingPipeMode Mode>
+bool RingPipe<T, Mode>::writeOrQueue(WriteAwaitable* writer) {
+    detail::WakeList wakeList;
+    bool queued = true;
+    {
+        std::scoped_lock lock {_mutex};
+        if (writer->_cancelled) {
+            return false;
+        }
+        _waitingWriters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_writers.empty() && _ring.tryPush(writer->_data)) {
+            _waitingWriters.fetch_sub(1, std::memory_order_relaxed);
+            writer->_written = true;
+            queued = false;
+        } else {
+            _writers.pushBack(writer);
+        }
+        transfer(wakeList);
+    }
+    wakeList.schedule();
+    return queued;
+}
+
+template <typename T, RingPipeMode Mode>
+bool RingPipe<T, Mode>::removeReader(ReadAwaitable* reader) {
+    std::scoped_lock lock {_mutex};
+    if (!reader->linked()) {
+        // either already received the data, or cancelled before being queued
+        reader->_cancelled = !reader->_data.has_value();
+        return false;
+    }
+    _readers.remove(reader);
+    _waitingReaders.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T, RingPipeMode Mode>
+bool RingPipe<T, Mode>::removeWriter(WriteAwaitable* writer) {
+    std::scoped_lock lock {_mutex};
+    if (!writer->linked()) {
+        // either already written, or cancelled before being queued
+        writer->_cancelled = !writer->_written;
+        return false;
+    }
+    _writers.remove(writer);
+    _waitingWriters.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T, RingPipeMode Mode>
+class [[nodiscard]] RingPipeReader {
+public:
+    RingPipeReader(RingPipe<T, Mode>& pipe)
+        : _pipe(pipe) {}
+
+private:
+    friend await_ready_trait<RingPipeReader>;
+    RingPipe<T, Mode>& _pipe;
+};
+
+template <typename T, RingPipeMode Mode>
+class [[nodiscard]] RingPipeWriter {
+public:
+    RingPipeWriter(RingPipe<T, Mode>& pipe, T&& data)
+        : _pipe(pipe)
+        , _data(std::move(data)) {}
+
+private:
+    friend await_ready_trait<RingPipeWriter>;
+    RingPipe<T, Mode>& _pipe;
+    T _data;
+};
+
+template <typename T, RingPipeMode Mode>
+struct await_ready_trait<RingPipeReader<T, Mode>> {
+    static detail::RingPipeReadAwaitable<T, Mode> await_transform(const PromiseBase& promise,
+                                                                  RingPipeReader<T, Mode>&& reader) {
+        return detail::RingPipeReadAwaitable<T, Mode> {&reader._pipe, promise};
+    }
+};
+
+template <typename T, RingPipeMode Mode>
+struct await_ready_trait<RingPipeWriter<T, Mode>> {
+    static detail::RingPipeWriteAwaitable<T, Mode> await_transform(const PromiseBase& promise,
+                                                                   RingPipeWriter<T, Mode>&& writer) {
+        return detail::RingPipeWriteAwaitable<T, Mode> {&writer._pipe, std::move(writer._data), promise};
+    }
+};
+
+} // namespace coro
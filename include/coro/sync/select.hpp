@@ -0,0 +1,266 @@
+#pragma once
+
+#include "pipe.hpp"
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/traits.hpp"
+#include "../detail/deadline_timer.hpp"
+#include "../detail/select_claim.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+#include "../sleep.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace coro {
+
+/**
+ * Request to wait for the first of the given sources, should be co_await(ed).
+ */
+template <typename... Sources>
+struct Select {
+    std::tuple<Sources...> sources;
+};
+
+/**
+ * Waits for the first completed source out of pipe reads and sleeps with a single awaiter.
+ * Example usage:
+ * @code
+ * auto result = co_await coro::select(requests.read(), control.next(), coro::sleep(100));
+ * switch (result.index()) {
+ *     case 0: handle(std::get<0>(result)); break;
+ *     case 1: ...; break; // std::optional, std::nullopt if the control pipe is closed
+ *     case 2: ...; break; // timeout, std::monostate
+ * }
+ * @endcode
+ * Results in std::variant holding the result of the completed source at its index, which are T for `pipe.read()`,
+ * std::optional<T> for `pipe.next()` and std::monostate for `coro::sleep()`. Exactly one source completes the select,
+ * so no data is lost: the pipes skip the already completed select and hand the data to their next reader. Readers are
+ * removed from the queues of the other pipes in O(1) once the select is resumed. The select fails with StopError or
+ * DeadlineExceeded if the task is stopped or its deadline expires first, and the completed `pipe.read()` rethrows
+ * PipeClosed at the end of the stream.
+ */
+template <typename... Sources>
+Select<std::remove_cvref_t<Sources>...> select(Sources&&... sources) {
+    static_assert(sizeof...(Sources) > 0, "At least one source should be given.");
+    return Select<std::remove_cvref_t<Sources>...> {{std::forward<Sources>(sources)...}};
+}
+
+namespace detail {
+
+template <typename Source>
+class SelectBranch;
+
+/**
+ * Reader of the pipe registered by the select, keeps the pipe data if it wins the select.
+ */
+template <typename T>
+class PipeSelectBranch : public PipeReaderNode<T> {
+public:
+    PipeSelectBranch(PipeDataReader<T>&& reader)
+        : PipeReaderNode<T>(nullptr)
+        , _pipe(reader._pipe) {}
+
+    PipeSelectBranch(PipeSelectBranch&& other) noexcept
+        : PipeReaderNode<T>(nullptr)
+        , _pipe(other._pipe) {}
+
+    void arm(SelectClaim& claim) {
+        if (claim.claimed()) {
+            return;
+        }
+        _select = &claim;
+        _executor = claim.executor;
+        _continuation = claim.continuation;
+        if (!_pipe.readOrQueue(this) && completed()) {
+            // took the available data right away
+            claim.complete();
+        }
+    }
+
+    void disarm() {
+        _pipe.removeReader(this);
+    }
+
+    bool completed() const noexcept {
+        return _data.has_value() || _closed;
+    }
+
+protected:
+    using PipeReaderNode<T>::_data;
+    using PipeReaderNode<T>::_closed;
+    using PipeReaderNode<T>::_executor;
+    using PipeReaderNode<T>::_continuation;
+    using PipeReaderNode<T>::_select;
+
+    Pipe<T>& _pipe;
+};
+
+template <typename T>
+class SelectBranch<PipeDataReader<T>> : public PipeSelectBranch<T> {
+public:
+    using Result = T;
+    using PipeSelectBranch<T>::PipeSelectBranch;
+
+    T take() {
+        if (!_data) {
+            throw PipeClosed {};
+        }
+        return std::move(_data).value();
+    }
+
+private:
+    using PipeSelectBranch<T>::_data;
+};
+
+template <typename T>
+class SelectBranch<PipeNextReader<T>> : public PipeSelectBranch<T> {
+public:
+    using Result = std::optional<T>;
+    using PipeSelectBranch<T>::PipeSelectBranch;
+
+    std::optional<T> take() {
+        return std::move(_data);
+    }
+
+private:
+    using PipeSelectBranch<T>::_data;
+};
+
+#ifndef CORO_EMSCRIPTEN
+/**
+ * Timeout of the select, completes it when the sleep duration passes.
+ */
+template <>
+class SelectBranch<SleepAwaitable> {
+public:
+    using Result = std::monostate;
+
+    SelectBranch(SleepAwaitable&& sleep)
+        : _duration(sleep.duration()) {}
+
+    SelectBranch(SelectBranch&& other) noexcept
+        : _duration(other._duration) {}
+
+    void arm(SelectClaim& claim) {
+        if (claim.claimed()) {
+            return;
+        }
+        _timer.arm(TimedScheduler::Clock::now() + std::chrono::milliseconds {_duration}, [this, &claim]() {
+            if (claim.claim()) {
+                _fired = true;
+                claim.complete();
+            }
+        });
+    }
+
+    void disarm() noexcept {
+        _timer.disarm();
+    }
+
+    bool completed() const noexcept {
+        return _fired;
+    }
+
+    std::monostate take() noexcept {
+        return {};
+    }
+
+private:
+    uint32_t _duration;
+    // Set by the timer thread before the select is resumed
+    bool _fired = false;
+    CancelTimer _timer;
+};
+#endif
+
+template <typename... Sources>
+class SelectAwaitable {
+public:
+    using Result = std::variant<typename SelectBranch<Sources>::Result...>;
+
+    SelectAwaitable(Select<Sources...>&& select, const PromiseBase& promise)
+        : _branches(std::make_from_tuple<std::tuple<SelectBranch<Sources>...>>(std::move(select.sources)))
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    SelectAwaitable(SelectAwaitable&& other) noexcept
+        : _branches(std::move(other._branches))
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() noexcept {
+        // expired deadline fails fast in await_resume() without taking any data
+        return detail::deadlineExceeded(_deadline);
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _claim.continuation = CoroHandle::fromTypedHandle(continuation);
+        _claim.executor = continuation.promise().executor.get();
+        // Armed before the registration, if the stop was already requested the select is claimed right away and
+        // none of the sources is registered.
+        _canceller.arm(this, _stopToken, _deadline);
+        std::apply([this](auto&... branches) { (branches.arm(_claim), ...); }, _branches);
+        // resumed right away if one of the sources has already completed during the registration
+        return !_claim.release();
+    }
+
+    Result await_resume() {
+        _canceller.disarm();
+        std::apply([](auto&... branches) { (branches.disarm(), ...); }, _branches);
+        return take<0>();
+    }
+
+private:
+    friend WaitCanceller<SelectAwaitable>;
+
+    void cancel() {
+        if (_claim.claim()) {
+            _claim.complete();
+        }
+    }
+
+    template <size_t I>
+    Result take() {
+        if constexpr (I == sizeof...(Sources)) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        } else {
+            auto& branch = std::get<I>(_branches);
+            if (branch.completed()) {
+                return Result {std::in_place_index<I>, branch.take()};
+            }
+            return take<I + 1>();
+        }
+    }
+
+private:
+    std::tuple<SelectBranch<Sources>...> _branches;
+    SelectClaim _claim;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<SelectAwaitable> _canceller;
+};
+
+} // namespace detail
+
+template <typename... Sources>
+struct await_ready_trait<Select<Sources...>> {
+    static detail::SelectAwaitable<Sources...> await_transform(const PromiseBase& promise,
+                                                              Select<Sources...>&& select) {
+        return detail::SelectAwaitable<Sources...> {std::move(select), promise};
+    }
+};
+
+} // namespace coro
@@ -0,0 +1,339 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace coro {
+
+class Semaphore;
+class SemaphorePermit;
+namespace detail {
+class SemaphoreAwaitable;
+}
+
+/**
+ * Request to acquire permits of the Semaphore, should be co_await(ed) to get the SemaphorePermit.
+ */
+struct SemaphoreAcquire {
+    Semaphore& semaphore;
+    size_t count;
+};
+
+/**
+ * Asynchronous counting semaphore with weighted acquire.
+ * Example usage: `auto permit = co_await semaphore.acquire(n);`
+ * co_await-ing to the acquire request returns SemaphorePermit, which releases the permits when goes out of the scope.
+ * Uncontended acquire and release are a single atomic operation. When there are not enough permits, awaiters are
+ * queued in FIFO order, so large requests are not starved by the small ones, and newcomers never overtake the queued
+ * awaiters. The queue is intrusive in the awaiters, and awaiter is removed from it in O(1) when its task is stopped
+ * or its deadline expires.
+ */
+class Semaphore {
+public:
+    explicit Semaphore(size_t permits)
+        : _state(permits * PermitUnit) {}
+
+    ~Semaphore() {
+        if (!_waiters.empty()) {
+            std::abort();
+        }
+    }
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+public:
+    SemaphoreAcquire acquire(size_t count = 1) {
+        return SemaphoreAcquire {*this, count};
+    }
+
+    /// Acquires permits without waiting, returns std::nullopt if there are not enough of them or there are waiters.
+    std::optional<SemaphorePermit> tryAcquire(size_t count = 1);
+
+    /// Returns permits to the semaphore, resuming queued awaiters which can be satisfied now.
+    void release(size_t count = 1);
+
+    /// Returns number of currently available permits.
+    size_t available() const noexcept {
+        return _state.load(std::memory_order_relaxed) / PermitUnit;
+    }
+
+private:
+    friend detail::SemaphoreAwaitable;
+
+    bool tryTake(size_t count) noexcept {
+        uint64_t state = _state.load(std::memory_order_relaxed);
+        while (!(state & WaitersBit) && state / PermitUnit >= count) {
+            if (_state.compare_exchange_weak(
+                    state, state - count * PermitUnit, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Takes the permits or queues the awaiter, returns true if the awaiter was queued.
+    bool takeOrQueue(detail::SemaphoreAwaitable* awaiter);
+
+    /// Removes the cancelled awaiter from the queue, returns false if it has already got the permits.
+    bool remove(detail::SemaphoreAwaitable* awaiter, detail::WakeList& wakeList);
+
+    /// Hands the permits over to the queued awaiters in FIFO order, should be called under the mutex.
+    void grant(detail::WakeList& wakeList);
+
+    /// Unlinks the awaiter from the queue in O(1) and clears the waiters bit once it is empty, should be called under
+    /// the mutex.
+    void unlink(detail::SemaphoreAwaitable* awaiter) noexcept;
+
+private:
+    // Permits are stored in the upper bits of the state, the lowest bit is set while there are queued awaiters.
+    // Lock free fast paths work only while the bit is clear, otherwise everything goes through the mutex.
+    static constexpr uint64_t WaitersBit = 1;
+    static constexpr uint64_t PermitUnit = 2;
+
+    std::atomic<uint64_t> _state;
+    detail::IntrusiveList<detail::SemaphoreAwaitable> _waiters;
+    std::mutex _mutex;
+};
+
+class SemaphorePermit {
+private:
+    friend Semaphore;
+    friend detail::SemaphoreAwaitable;
+    SemaphorePermit(Semaphore* semaphore, size_t count)
+        : _semaphore(semaphore)
+        , _count(count) {}
+
+public:
+    // Move only
+    SemaphorePermit(const SemaphorePermit&) = delete;
+    SemaphorePermit& operator=(const SemaphorePermit&) = delete;
+
+    SemaphorePermit(SemaphorePermit&& other) noexcept
+        : _semaphore(std::exchange(other._semaphore, nullptr))
+        , _count(other._count) {}
+
+    SemaphorePermit& operator=(SemaphorePermit&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _semaphore = std::exchange(other._semaphore, nullptr);
+            _count = other._count;
+        }
+        return *this;
+    }
+
+    ~SemaphorePermit() {
+        reset();
+    }
+
+public:
+    size_t count() const noexcept {
+        return _semaphore ? _count : 0;
+    }
+
+    void reset() {
+        if (_semaphore) {
+            _semaphore->release(_count);
+            _semaphore = nullptr;
+        }
+    }
+
+private:
+    Semaphore* _semaphore;
+    size_t _count;
+};
+
+namespace detail {
+
+class SemaphoreAwaitable : public IntrusiveListNode<SemaphoreAwaitable> {
+private:
+    friend await_ready_trait<SemaphoreAcquire>;
+
+    SemaphoreAwaitable(const SemaphoreAcquire& request, const PromiseBase& promise)
+        : _semaphore(&request.semaphore)
+        , _count(request.count)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+public:
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    SemaphoreAwaitable(SemaphoreAwaitable&& other) noexcept
+        : _semaphore(other._semaphore)
+        , _count(other._count)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool await_ready() noexcept {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without acquiring
+            return true;
+        }
+        _granted = _semaphore->tryTake(_count);
+        return _granted;
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        _continuation = CoroHandle::fromTypedHandle(continuation);
+        // Armed before queueing, so the awaiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the awaiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _semaphore->takeOrQueue(this);
+    }
+
+    SemaphorePermit await_resume() {
+        _canceller.disarm();
+        if (!_granted) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        SemaphorePermit permit {_semaphore, _count};
+        _stopToken.throwIfStopped();
+        return permit;
+    }
+
+    Result<SemaphorePermit> await_resume_result() {
+        _canceller.disarm();
+        std::optional<SemaphorePermit> permit;
+        if (_granted) {
+            permit.emplace(SemaphorePermit {_semaphore, _count});
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<SemaphorePermit>::stopped();
+        }
+        if (!permit) {
+            return Result<SemaphorePermit> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<SemaphorePermit> {std::move(*permit)};
+    }
+
+private:
+    friend Semaphore;
+    friend WaitCanceller<SemaphoreAwaitable>;
+
+    void cancel() {
+        WakeList wakeList;
+        if (_semaphore->remove(this, wakeList)) {
+            wakeList.push(_executor, _continuation);
+        }
+        wakeList.schedule();
+    }
+
+    Semaphore* _semaphore;
+    size_t _count;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<SemaphoreAwaitable> _canceller;
+    // Set when the awaiter was cancelled before it was queued, guarded by the semaphore mutex.
+    bool _cancelled = false;
+    bool _granted = false;
+};
+
+} // namespace detail
+
+inline std::optional<SemaphorePermit> Semaphore::tryAcquire(size_t count) {
+    if (tryTake(count)) {
+        return SemaphorePermit {this, count};
+    }
+    return std::nullopt;
+}
+
+inline void Semaphore::release(size_t count) {
+    uint64_t state = _state.load(std::memory_order_relaxed);
+    while (!(state & WaitersBit)) {
+        if (_state.compare_exchange_weak(
+                state, state + count * PermitUnit, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _state.fetch_add(count * PermitUnit, std::memory_order_release);
+        grant(wakeList);
+    }
+    wakeList.schedule();
+}
+
+inline bool Semaphore::takeOrQueue(detail::SemaphoreAwaitable* awaiter) {
+    std::scoped_lock lock {_mutex};
+    if (awaiter->_cancelled) {
+        return false;
+    }
+    if (tryTake(awaiter->_count)) {
+        awaiter->_granted = true;
+        return false;
+    }
+    if (_waiters.empty()) {
+        const uint64_t state = _state.fetch_or(WaitersBit, std::memory_order_acq_rel);
+        // Permits might have been released by the fast path right after the attempt above. Once the bit is set they
+        // are changed only under the mutex, so check them once more before queueing.
+        if (state / PermitUnit >= awaiter->_count) {
+            _state.fetch_sub(awaiter->_count * PermitUnit + WaitersBit, std::memory_order_acquire);
+            awaiter->_granted = true;
+            return false;
+        }
+    }
+    // Not registered with executor->external(), the own stop callback makes sure the awaiter is resumed only once,
+    // either by the release() or by the stop request.
+    _waiters.pushBack(awaiter);
+    return true;
+}
+
+inline bool Semaphore::remove(detail::SemaphoreAwaitable* awaiter, detail::WakeList& wakeList) {
+    std::scoped_lock lock {_mutex};
+    if (!awaiter->linked()) {
+        // either already granted, or cancelled before being queued
+        awaiter->_cancelled = !awaiter->_granted;
+        return false;
+    }
+    unlink(awaiter);
+    // the removed awaiter might have blocked the smaller requests queued after it
+    grant(wakeList);
+    return true;
+}
+
+inline void Semaphore::grant(detail::WakeList& wakeList) {
+    while (auto* awaiter = _waiters.front()) {
+        if (_state.load(std::memory_order_relaxed) / PermitUnit < awaiter->_count) {
+            break;
+        }
+        _state.fetch_sub(awaiter->_count * PermitUnit, std::memory_order_acquire);
+        unlink(awaiter);
+        awaiter->_granted = true;
+        wakeList.push(awaiter->_executor, awaiter->_continuation);
+    }
+}
+
+inline void Semaphore::unlink(detail::SemaphoreAwaitable* awaiter) noexcept {
+    _waiters.remove(awaiter);
+    if (_waiters.empty()) {
+        _state.fetch_and(~WaitersBit, std::memory_order_release);
+    }
+}
+
+template <>
+struct await_ready_trait<SemaphoreAcquire> {
+    static detail::SemaphoreAwaitable await_transform(const PromiseBase& promise, SemaphoreAcquire&& request) {
+        return detail::SemaphoreAwaitable {request, promise};
+    }
+};
+
+} // namespace coro
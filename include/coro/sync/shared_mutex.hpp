@@ -0,0 +1,399 @@
+#pragma once
+
+#include "../core/deadline.hpp"
+#include "../core/executor.hpp"
+#include "../core/promise_base.hpp"
+#include "../core/result.hpp"
+#include "../core/traits.hpp"
+#include "../detail/containers.hpp"
+#include "../detail/wait_canceller.hpp"
+#include "../detail/wake_list.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace coro {
+
+class SharedMutex;
+template <bool Shared>
+class SharedMutexLock;
+namespace detail {
+class SharedMutexWaiter;
+template <bool Shared>
+class SharedMutexAwaitable;
+} // namespace detail
+
+/**
+ * Request to lock the SharedMutex in shared or exclusive mode, should be co_await(ed) to get the lock.
+ */
+template <bool Shared>
+struct SharedMutexRequest {
+    SharedMutex& mutex;
+};
+
+/**
+ * Asynchronous reader-writer mutex.
+ * Example usage: `auto lock = co_await mutex.lockShared();` or `auto lock = co_await mutex.lock();`
+ * co_await-ing to the lock request returns SharedLock or UniqueLock respectively, which unlock the mutex when go out
+ * of the scope.
+ * Locking and unlocking while nobody waits is a single atomic operation, so readers do not serialize on each other.
+ * Writers are prioritized: once a writer is waiting, newcoming readers are queued behind it instead of extending the
+ * shared ownership, and the writer gets the lock as soon as the current readers are done. When a writer unlocks,
+ * all the readers queued meanwhile are released in one batch.
+ * Waiters are queued intrusively and removed in O(1) when their task is stopped or their deadline expires.
+ */
+class SharedMutex {
+public:
+    SharedMutex() = default;
+
+    ~SharedMutex() {
+        if (!_readers.empty() || !_writers.empty()) {
+            std::abort();
+        }
+    }
+
+    SharedMutex(const SharedMutex&) = delete;
+    SharedMutex& operator=(const SharedMutex&) = delete;
+
+public:
+    SharedMutexRequest<true> lockShared() {
+        return SharedMutexRequest<true> {*this};
+    }
+
+    SharedMutexRequest<false> lock() {
+        return SharedMutexRequest<false> {*this};
+    }
+
+    /// Locks the mutex in shared mode without waiting, returns std::nullopt if it is locked or there are waiters.
+    std::optional<SharedMutexLock<true>> tryLockShared();
+
+    /// Locks the mutex in exclusive mode without waiting, returns std::nullopt if it is locked or there are waiters.
+    std::optional<SharedMutexLock<false>> tryLock();
+
+private:
+    template <bool Shared>
+    friend class SharedMutexLock;
+    friend detail::SharedMutexWaiter;
+
+    bool tryTake(bool shared) noexcept {
+        if (shared) {
+            uint64_t state = _state.load(std::memory_order_relaxed);
+            while (!(state & (WriterBit | WaitersBit))) {
+                if (_state.compare_exchange_weak(
+                        state, state + ReaderUnit, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        uint64_t state = 0;
+        return _state.compare_exchange_strong(state, WriterBit, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlockShared();
+    void unlock();
+
+    /// Takes the lock or queues the waiter, returns true if the waiter was queued.
+    bool takeOrQueue(detail::SharedMutexWaiter* waiter);
+
+    /// Removes the cancelled waiter from the queue, returns false if it has already got the lock.
+    bool remove(detail::SharedMutexWaiter* waiter, detail::WakeList& wakeList);
+
+    /// Hands the lock over to the queued waiters, should be called under the mutex.
+    /// Queued readers take precedence over the writers only right after the writer unlocks.
+    void grant(detail::WakeList& wakeList, bool writerUnlocked);
+
+private:
+    // The lowest bit is set while the mutex is locked exclusively, the next one while there are queued waiters,
+    // and the number of readers is stored in the upper bits. Lock free fast paths work only while the waiters bit is
+    // clear, otherwise everything goes through the mutex.
+    static constexpr uint64_t WriterBit = 1;
+    static constexpr uint64_t WaitersBit = 2;
+    static constexpr uint64_t ReaderUnit = 4;
+
+    std::atomic<uint64_t> _state = 0;
+    detail::IntrusiveList<detail::SharedMutexWaiter> _readers;
+    detail::IntrusiveList<detail::SharedMutexWaiter> _writers;
+    std::mutex _mutex;
+};
+
+template <bool Shared>
+class SharedMutexLock {
+private:
+    friend SharedMutex;
+    friend detail::SharedMutexAwaitable<Shared>;
+    SharedMutexLock(SharedMutex* mutex)
+        : _mutex(mutex) {}
+
+public:
+    // Move only
+    SharedMutexLock(const SharedMutexLock&) = delete;
+    SharedMutexLock& operator=(const SharedMutexLock&) = delete;
+
+    SharedMutexLock(SharedMutexLock&& other) noexcept
+        : _mutex(std::exchange(other._mutex, nullptr)) {}
+
+    SharedMutexLock& operator=(SharedMutexLock&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _mutex = std::exchange(other._mutex, nullptr);
+        }
+        return *this;
+    }
+
+    ~SharedMutexLock() {
+        reset();
+    }
+
+public:
+    void reset() {
+        if (_mutex) {
+            if constexpr (Shared) {
+                _mutex->unlockShared();
+            } else {
+                _mutex->unlock();
+            }
+            _mutex = nullptr;
+        }
+    }
+
+private:
+    SharedMutex* _mutex;
+};
+
+using SharedLock = SharedMutexLock<true>;
+using UniqueLock = SharedMutexLock<false>;
+
+namespace detail {
+
+/**
+ * Part of the SharedMutex awaiter which does not depend on the lock mode, queued in the SharedMutex lists.
+ */
+class SharedMutexWaiter : public IntrusiveListNode<SharedMutexWaiter> {
+protected:
+    SharedMutexWaiter(SharedMutex* mutex, bool shared, const PromiseBase& promise)
+        : _mutex(mutex)
+        , _shared(shared)
+        , _executor(promise.executor.get())
+        , _stopToken(promise.context->stopToken)
+        , _deadline(promise.context->deadline) {}
+
+    // Movable only before being awaited, e.g. by coro::nothrow()
+    SharedMutexWaiter(SharedMutexWaiter&& other) noexcept
+        : _mutex(other._mutex)
+        , _shared(other._shared)
+        , _executor(other._executor)
+        , _stopToken(std::move(other._stopToken))
+        , _deadline(other._deadline) {}
+
+    bool ready() noexcept {
+        if (detail::deadlineExceeded(_deadline)) {
+            // fail fast without locking
+            return true;
+        }
+        _granted = _mutex->tryTake(_shared);
+        return _granted;
+    }
+
+    bool suspend(CoroHandle&& continuation) {
+        _continuation = std::move(continuation);
+        // Armed before queueing, so the waiter is never resumed while the callbacks are being registered.
+        // If the stop was already requested the waiter is cancelled right away and is not queued at all.
+        _canceller.arm(this, _stopToken, _deadline);
+        return _mutex->takeOrQueue(this);
+    }
+
+private:
+    friend SharedMutex;
+    friend WaitCanceller<SharedMutexWaiter>;
+
+    void cancel() {
+        WakeList wakeList;
+        if (_mutex->remove(this, wakeList)) {
+            wakeList.push(_executor, _continuation);
+        }
+        wakeList.schedule();
+    }
+
+protected:
+    SharedMutex* _mutex;
+    bool _shared;
+    Executor* _executor;
+    CoroHandle _continuation;
+    StopToken _stopToken;
+    Deadline _deadline;
+    WaitCanceller<SharedMutexWaiter> _canceller;
+    // Set when the waiter was cancelled before it was queued, guarded by the shared mutex.
+    bool _cancelled = false;
+    bool _granted = false;
+};
+
+template <bool Shared>
+class SharedMutexAwaitable : private SharedMutexWaiter {
+    using Lock = SharedMutexLock<Shared>;
+
+private:
+    friend await_ready_trait<SharedMutexRequest<Shared>>;
+
+    SharedMutexAwaitable(SharedMutex* mutex, const PromiseBase& promise)
+        : SharedMutexWaiter(mutex, Shared, promise) {}
+
+public:
+    SharedMutexAwaitable(SharedMutexAwaitable&&) noexcept = default;
+
+    bool await_ready() noexcept {
+        return ready();
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> continuation) {
+        return suspend(CoroHandle::fromTypedHandle(continuation));
+    }
+
+    Lock await_resume() {
+        _canceller.disarm();
+        if (!_granted) {
+            _stopToken.throwIfStopped();
+            throw DeadlineExceeded {};
+        }
+        Lock lock {_mutex};
+        _stopToken.throwIfStopped();
+        return lock;
+    }
+
+    Result<Lock> await_resume_result() {
+        _canceller.disarm();
+        std::optional<Lock> lock;
+        if (_granted) {
+            lock.emplace(Lock {_mutex});
+        }
+        if (_stopToken.stopRequested()) {
+            return Result<Lock>::stopped();
+        }
+        if (!lock) {
+            return Result<Lock> {std::make_exception_ptr(DeadlineExceeded {})};
+        }
+        return Result<Lock> {std::move(*lock)};
+    }
+};
+
+} // namespace detail
+
+inline std::optional<SharedLock> SharedMutex::tryLockShared() {
+    if (tryTake(true)) {
+        return SharedLock {this};
+    }
+    return std::nullopt;
+}
+
+inline std::optional<UniqueLock> SharedMutex::tryLock() {
+    if (tryTake(false)) {
+        return UniqueLock {this};
+    }
+    return std::nullopt;
+}
+
+inline void SharedMutex::unlockShared() {
+    uint64_t state = _state.load(std::memory_order_relaxed);
+    while (!(state & WaitersBit)) {
+        if (_state.compare_exchange_weak(
+                state, state - ReaderUnit, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _state.fetch_sub(ReaderUnit, std::memory_order_release);
+        grant(wakeList, false);
+    }
+    wakeList.schedule();
+}
+
+inline void SharedMutex::unlock() {
+    uint64_t state = WriterBit;
+    if (_state.compare_exchange_strong(state, 0, std::memory_order_release, std::memory_order_relaxed)) {
+        return;
+    }
+    detail::WakeList wakeList;
+    {
+        std::scoped_lock lock {_mutex};
+        _state.fetch_and(~WriterBit, std::memory_order_release);
+        grant(wakeList, true);
+    }
+    wakeList.schedule();
+}
+
+inline bool SharedMutex::takeOrQueue(detail::SharedMutexWaiter* waiter) {
+    std::scoped_lock lock {_mutex};
+    if (waiter->_cancelled) {
+        return false;
+    }
+    uint64_t state = _state.load(std::memory_order_relaxed);
+    if (_readers.empty() && _writers.empty()) {
+        // Once the bit is set the state is changed only under the mutex, so the check below can not be outdated by
+        // the concurrent fast path.
+        state = _state.fetch_or(WaitersBit, std::memory_order_acq_rel) | WaitersBit;
+    }
+    const bool free = _writers.empty() && (waiter->_shared ? !(state & WriterBit) : state == WaitersBit);
+    if (free) {
+        _state.fetch_add(waiter->_shared ? ReaderUnit : WriterBit, std::memory_order_acquire);
+        waiter->_granted = true;
+        if (_readers.empty() && _writers.empty()) {
+            _state.fetch_and(~WaitersBit, std::memory_order_release);
+        }
+        return false;
+    }
+    (waiter->_shared ? _readers : _writers).pushBack(waiter);
+    return true;
+}
+
+inline bool SharedMutex::remove(detail::SharedMutexWaiter* waiter, detail::WakeList& wakeList) {
+    std::scoped_lock lock {_mutex};
+    if (!waiter->linked()) {
+        // either already granted, or cancelled before being queued
+        waiter->_cancelled = !waiter->_granted;
+        return false;
+    }
+    (waiter->_shared ? _readers : _writers).remove(waiter);
+    // the removed writer might have blocked the readers queued after it
+    grant(wakeList, false);
+    return true;
+}
+
+inline void SharedMutex::grant(detail::WakeList& wakeList, bool writerUnlocked) {
+    const uint64_t state = _state.load(std::memory_order_relaxed);
+    if (!(state & WriterBit)) {
+        if (!_readers.empty() && (writerUnlocked || _writers.empty())) {
+            uint64_t readers = 0;
+            while (auto* reader = _readers.popFront()) {
+                reader->_granted = true;
+                wakeList.push(reader->_executor, reader->_continuation);
+                ++readers;
+            }
+            _state.fetch_add(readers * ReaderUnit, std::memory_order_acquire);
+        } else if (!_writers.empty() && state < ReaderUnit) {
+            auto* writer = _writers.popFront();
+            writer->_granted = true;
+            wakeList.push(writer->_executor, writer->_continuation);
+            _state.fetch_or(WriterBit, std::memory_order_acquire);
+        }
+    }
+    if (_readers.empty() && _writers.empty()) {
+        _state.fetch_and(~WaitersBit, std::memory_order_release);
+    }
+}
+
+template <bool Shared>
+struct await_ready_trait<SharedMutexRequest<Shared>> {
+    static detail::SharedMutexAwaitable<Shared> await_transform(const PromiseBase& promise,
+                                                                SharedMutexRequest<Shared>&& request) {
+        return detail::SharedMutexAwaitable<Shared> {&request.mutex, promise};
+    }
+};
+
+} // namespace coro
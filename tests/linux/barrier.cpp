@@ -0,0 +1,77 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/barrier.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+constexpr int Participants = 6;
+constexpr int Rounds = 50;
+
+coro::Task<void> participant(coro::Barrier& barrier, std::atomic<int>& arrived, std::atomic<int>& mismatches) {
+    for (int round = 0; round < Rounds; ++round) {
+        ++arrived;
+        co_await barrier.arriveAndWait();
+        // everybody has arrived at this round and nobody has arrived at the next one yet
+        if (arrived.load() < (round + 1) * Participants) {
+            ++mismatches;
+        }
+        co_await barrier.arriveAndWait();
+    }
+}
+
+TEST(Barrier, Phases) {
+    std::atomic<int> arrived = 0;
+    std::atomic<int> mismatches = 0;
+    int phases = 0;
+    coro::Barrier barrier {Participants, [&] { ++phases; }};
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < Participants; ++i) {
+        if (i % 2 == 0) {
+            executors.push_back(coro::SerialExecutor::create());
+        }
+        futures.push_back(executors.back()->future(participant(barrier, arrived, mismatches)));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_EQ(arrived, Participants * Rounds);
+    EXPECT_EQ(phases, 2 * Rounds);
+}
+
+TEST(Barrier, ArriveAndDrop) {
+    auto executor = coro::SerialExecutor::create();
+    int phases = 0;
+    coro::Barrier barrier {3, [&] { ++phases; }};
+    auto worker = [](coro::Barrier& barrier, int rounds) -> coro::Task<void> {
+        for (int i = 0; i < rounds; ++i) {
+            co_await barrier.arriveAndWait();
+        }
+        barrier.arriveAndDrop();
+    };
+    auto first = executor->future(worker(barrier, 1));
+    auto second = executor->future(worker(barrier, 3));
+    auto third = executor->future(worker(barrier, 3));
+    first.get();
+    second.get();
+    third.get();
+    // the drop of the first worker completes the second phase, the next ones expect only two participants
+    EXPECT_EQ(phases, 4);
+}
+
+TEST(Barrier, Stop) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Barrier barrier {2};
+    coro::StopSource stopSource;
+    auto waiter = [](coro::Barrier& barrier) -> coro::Task<void> { co_await barrier.arriveAndWait(); };
+    auto future = executor->future(waiter(barrier).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(10ms);
+    stopSource.requestStop();
+    EXPECT_THROW(future.get(), coro::StopError);
+    // the stopped waiter has arrived, so the next arrival completes the phase
+    EXPECT_NO_THROW(executor->syncWait(waiter(barrier)));
+}
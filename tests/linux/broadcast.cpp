@@ -0,0 +1,97 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/broadcast.hpp>
+
+#include <gtest/gtest.h>
+
+coro::Task<int> sumOf(coro::BroadcastSubscriber<int>& subscriber, int count) {
+    int sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += co_await subscriber.next();
+    }
+    co_return sum;
+}
+
+TEST(Broadcast, FanOut) {
+    constexpr int Items = 1000;
+    coro::Broadcast<int> broadcast {16, coro::BroadcastPolicy::Block};
+    std::vector<coro::BroadcastSubscriber<int>> subscribers;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<int>> sums;
+    for (int i = 0; i < 3; ++i) {
+        subscribers.push_back(broadcast.subscribe());
+    }
+    for (auto& subscriber : subscribers) {
+        executors.push_back(coro::SerialExecutor::create());
+        sums.push_back(executors.back()->future(sumOf(subscriber, Items)));
+    }
+    auto producer = coro::SerialExecutor::create();
+    producer->syncWait([](coro::Broadcast<int>& broadcast) -> coro::Task<void> {
+        for (int i = 1; i <= Items; ++i) {
+            co_await broadcast.publish(i);
+        }
+    }(broadcast));
+    for (auto& sum : sums) {
+        EXPECT_EQ(sum.get(), Items * (Items + 1) / 2);
+    }
+}
+
+TEST(Broadcast, DropOldest) {
+    coro::Broadcast<int> broadcast {4};
+    // published without subscribers and dropped
+    EXPECT_TRUE(broadcast.tryPublish(100));
+    auto fast = broadcast.subscribe();
+    auto slow = broadcast.subscribe();
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_TRUE(broadcast.tryPublish(i));
+        EXPECT_EQ(fast.tryNext(), i);
+    }
+    // the slow subscriber skips the overwritten items
+    EXPECT_EQ(slow.tryNext(), 2);
+    EXPECT_EQ(slow.missed(), 2);
+    EXPECT_EQ(fast.missed(), 0);
+    EXPECT_EQ(slow.tryNext(), 3);
+    EXPECT_EQ(slow.tryNext(), 4);
+    EXPECT_EQ(slow.tryNext(), 5);
+    EXPECT_FALSE(slow.tryNext().has_value());
+    EXPECT_FALSE(fast.tryNext().has_value());
+}
+
+TEST(Broadcast, Block) {
+    coro::Broadcast<int> broadcast {2, coro::BroadcastPolicy::Block};
+    auto fast = broadcast.subscribe();
+    std::optional<coro::BroadcastSubscriber<int>> slow {broadcast.subscribe()};
+    EXPECT_TRUE(broadcast.tryPublish(1));
+    EXPECT_TRUE(broadcast.tryPublish(2));
+    EXPECT_FALSE(broadcast.tryPublish(3));
+    auto executor = coro::SerialExecutor::create();
+    auto publishing = executor->future([](coro::Broadcast<int>& broadcast) -> coro::Task<void> {
+        co_await broadcast.publish(3);
+    }(broadcast));
+    EXPECT_EQ(fast.tryNext(), 1);
+    EXPECT_EQ(fast.tryNext(), 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    // still blocked by the slow subscriber
+    EXPECT_EQ(publishing.wait_for(std::chrono::milliseconds {0}), std::future_status::timeout);
+    EXPECT_EQ(slow->tryNext(), 1);
+    publishing.get();
+    EXPECT_EQ(fast.tryNext(), 3);
+    // unsubscribing releases the unread items
+    slow.reset();
+    EXPECT_TRUE(broadcast.tryPublish(4));
+    EXPECT_TRUE(broadcast.tryPublish(5));
+}
+
+TEST(Broadcast, Stop) {
+    coro::Broadcast<int> broadcast {2};
+    auto subscriber = broadcast.subscribe();
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    auto reading = executor->future(sumOf(subscriber, 1).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    stopSource.requestStop();
+    EXPECT_THROW(reading.get(), coro::StopError);
+    EXPECT_TRUE(broadcast.tryPublish(7));
+    EXPECT_EQ(subscriber.tryNext(), 7);
+}
@@ -0,0 +1,191 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/nothrow.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/condition_variable.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+struct Queue {
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    std::vector<int> items;
+    bool done = false;
+};
+
+coro::Task<int> consume(Queue& queue) {
+    int sum = 0;
+    while (true) {
+        auto lock = co_await queue.mutex;
+        co_await queue.condition.wait(lock, [&] { return !queue.items.empty() || queue.done; });
+        if (queue.items.empty()) {
+            co_return sum;
+        }
+        sum += queue.items.back();
+        queue.items.pop_back();
+    }
+}
+
+coro::Task<void> produce(Queue& queue, int count) {
+    for (int i = 1; i <= count; ++i) {
+        {
+            auto lock = co_await queue.mutex;
+            queue.items.push_back(i);
+        }
+        queue.condition.notifyOne();
+        co_await coro::sleep(1);
+    }
+}
+
+TEST(ConditionVariable, ProducerConsumers) {
+    Queue queue;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<int>> consumers;
+    for (int i = 0; i < 3; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        consumers.push_back(executors.back()->future(consume(queue)));
+    }
+    auto producer = coro::SerialExecutor::create();
+    producer->syncWait(produce(queue, 100));
+    producer->syncWait([](Queue& queue) -> coro::Task<void> {
+        auto lock = co_await queue.mutex;
+        queue.done = true;
+    }(queue));
+    queue.condition.notifyAll();
+    int sum = 0;
+    for (auto& consumer : consumers) {
+        sum += consumer.get();
+    }
+    EXPECT_EQ(sum, 5050);
+}
+
+TEST(ConditionVariable, NotifyAll) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    int woken = 0;
+    auto waiter = [](coro::Mutex& mutex, coro::ConditionVariable& condition, int& woken) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await condition.wait(lock);
+        EXPECT_NE(lock.mutex(), nullptr);
+        ++woken;
+    };
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 5; ++i) {
+        futures.push_back(executor->future(waiter(mutex, condition, woken)));
+    }
+    std::this_thread::sleep_for(20ms);
+    condition.notifyAll();
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(woken, 5);
+}
+
+TEST(ConditionVariable, StopReleasesLock) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    coro::StopSource stopSource;
+    auto waiter = [](coro::Mutex& mutex, coro::ConditionVariable& condition) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await condition.wait(lock);
+    };
+    auto future = executor->future(waiter(mutex, condition).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(10ms);
+    stopSource.requestStop();
+    EXPECT_THROW(future.get(), coro::StopError);
+    // the stopped waiter has left the queue and the mutex is unlocked
+    auto locker = [](coro::Mutex& mutex) -> coro::Task<void> { auto lock = co_await mutex; };
+    EXPECT_NO_THROW(executor->syncWait(locker(mutex)));
+}
+
+TEST(ConditionVariable, PredicateRecheckedWithoutResume) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    int value = 0;
+    int checks = 0;
+    auto waiter = [](coro::Mutex& mutex, coro::ConditionVariable& condition, int& value, int& checks)
+        -> coro::Task<int> {
+        auto lock = co_await mutex;
+        co_await condition.wait(lock, [&] {
+            ++checks;
+            return value == 3;
+        });
+        EXPECT_NE(lock.mutex(), nullptr);
+        co_return value;
+    };
+    auto future = executor->future(waiter(mutex, condition, value, checks));
+    auto setter = [](coro::Mutex& mutex, int& value, int next) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        value = next;
+    };
+    for (int i = 1; i <= 3; ++i) {
+        std::this_thread::sleep_for(5ms);
+        executor->syncWait(setter(mutex, value, i));
+        condition.notifyOne();
+    }
+    EXPECT_EQ(future.get(), 3);
+    // checked before suspending and once per notification
+    EXPECT_EQ(checks, 4);
+}
+
+TEST(ConditionVariable, DeadlineNoThrow) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    auto waiter = [](coro::Mutex& mutex, coro::ConditionVariable& condition) -> coro::Task<bool> {
+        auto lock = co_await mutex;
+        auto result = co_await coro::nothrow(condition.wait(lock, [] { return false; }));
+        EXPECT_EQ(lock.mutex(), nullptr);
+        co_return result.hasError();
+    };
+    auto deadline = coro::Deadline::clock::now() + 20ms;
+    EXPECT_TRUE(executor->syncWait(waiter(mutex, condition).setDeadline(deadline)));
+    auto locker = [](coro::Mutex& mutex) -> coro::Task<void> { auto lock = co_await mutex; };
+    EXPECT_NO_THROW(executor->syncWait(locker(mutex)));
+}
+
+TEST(ConditionVariable, SpuriousNotifyAllManyWaiters) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    coro::ConditionVariable condition;
+    bool ready = false;
+    std::vector<int> order;
+    constexpr int count = 50000;
+    coro::Latch done {count};
+    auto waiter = [](coro::Mutex& mutex, coro::ConditionVariable& condition, bool& ready, std::vector<int>& order,
+                     coro::Latch& done, int id) -> coro::Task<void> {
+        {
+            auto lock = co_await mutex;
+            co_await condition.wait(lock, [&] { return ready; });
+            order.push_back(id);
+        }
+        done.count_down();
+    };
+    for (int i = 0; i < count; ++i) {
+        executor->schedule(waiter(mutex, condition, ready, order, done, i));
+    }
+    auto notifier = [](coro::Mutex& mutex, coro::ConditionVariable& condition, bool& ready,
+                       coro::Latch& done) -> coro::Task<void> {
+        {
+            // every waiter is handed the lock and requeued by the unlock, without being resumed
+            auto lock = co_await mutex;
+            condition.notifyAll();
+        }
+        {
+            auto lock = co_await mutex;
+            ready = true;
+            condition.notifyAll();
+        }
+        co_await done;
+    };
+    executor->syncWait(notifier(mutex, condition, ready, done));
+    ASSERT_EQ(order.size(), count);
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
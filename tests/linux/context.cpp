@@ -0,0 +1,50 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+
+#include <gtest/gtest.h>
+
+coro::Task<const coro::TaskContext*> contextAddress() {
+    const coro::TaskContext& context = co_await coro::currentContext;
+    co_return &context;
+}
+
+TEST(Context, Shared) {
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    auto result = executor->syncWait([]() -> coro::Task<std::vector<bool>> {
+        const coro::TaskContext& context = co_await coro::currentContext;
+        std::vector<bool> shared;
+        // children inherit the very same context object
+        shared.push_back(co_await contextAddress() == &context);
+        shared.push_back(co_await contextAddress() == &context);
+        // child tightening the deadline gets own copy
+        auto deadline = coro::Deadline::clock::now() + std::chrono::seconds {1};
+        auto* own = co_await contextAddress().setDeadline(deadline);
+        shared.push_back(own == &context);
+        co_return shared;
+    }().setStopToken(stopSource.token()));
+    EXPECT_EQ(result, (std::vector {true, true, false}));
+}
+
+TEST(Context, CopyOnWrite) {
+    coro::StopSource stopSource;
+    coro::ContextRef empty;
+    EXPECT_FALSE(empty);
+    EXPECT_FALSE(empty->stopToken);
+    EXPECT_EQ(empty->deadline, coro::Deadline::max());
+
+    coro::ContextRef context;
+    context.mutate().stopToken = stopSource.token();
+    const coro::TaskContext* address = &*context;
+    // not shared context is modified in place
+    context.mutate().linkStopTokens = true;
+    EXPECT_EQ(&*context, address);
+
+    coro::ContextRef copy = context;
+    EXPECT_EQ(&*copy, address);
+    copy.mutate().linkStopTokens = false;
+    EXPECT_NE(&*copy, address);
+    EXPECT_EQ(copy->stopToken, stopSource.token());
+    EXPECT_TRUE(context->linkStopTokens);
+    EXPECT_FALSE(copy->linkStopTokens);
+}
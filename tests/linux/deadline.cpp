@@ -0,0 +1,109 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/latch.hpp>
+#include <coro/sync/mutex.hpp>
+#include <coro/sync/pipe.hpp>
+#include <coro/sync/semaphore.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+coro::Deadline in(std::chrono::milliseconds time) {
+    return coro::Deadline::clock::now() + time;
+}
+
+coro::Task<void> sleeper(uint32_t time) {
+    co_await coro::sleep(time);
+}
+
+TEST(Deadline, Sleep) {
+    auto executor = coro::SerialExecutor::create();
+    auto start = coro::Deadline::clock::now();
+    EXPECT_THROW(executor->syncWait(sleeper(1000).setDeadline(in(20ms))), coro::DeadlineExceeded);
+    // the timer fires at the deadline rather than at the end of the sleep
+    EXPECT_LT(coro::Deadline::clock::now() - start, 500ms);
+    // sleep within the budget succeeds
+    EXPECT_NO_THROW(executor->syncWait(sleeper(1).setDeadline(in(500ms))));
+}
+
+coro::Task<coro::Deadline> currentDeadline() {
+    co_return co_await coro::currentDeadline;
+}
+
+TEST(Deadline, Inheritance) {
+    auto executor = coro::SerialExecutor::create();
+    const auto parent = in(1000ms);
+    const auto tighter = in(500ms);
+    auto result = executor->syncWait([](coro::Deadline tighter) -> coro::Task<std::vector<coro::Deadline>> {
+        std::vector<coro::Deadline> deadlines;
+        deadlines.push_back(co_await coro::currentDeadline);
+        deadlines.push_back(co_await currentDeadline());
+        deadlines.push_back(co_await currentDeadline().setDeadline(tighter));
+        deadlines.push_back(co_await currentDeadline().setDeadline(coro::Deadline::max()));
+        co_return deadlines;
+    }(tighter).setDeadline(parent));
+    EXPECT_EQ(result, (std::vector {parent, parent, tighter, parent}));
+    EXPECT_EQ(executor->syncWait(currentDeadline()), coro::Deadline::max());
+}
+
+TEST(Deadline, Mutex) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    auto holder = executor->future([](coro::Mutex& mutex) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await coro::sleep(100);
+    }(mutex));
+    std::this_thread::sleep_for(10ms);
+    auto waiter = [](coro::Mutex& mutex) -> coro::Task<void> { auto lock = co_await mutex; };
+    auto start = coro::Deadline::clock::now();
+    EXPECT_THROW(executor->syncWait(waiter(mutex).setDeadline(in(20ms))), coro::DeadlineExceeded);
+    EXPECT_LT(coro::Deadline::clock::now() - start, 90ms);
+    holder.get();
+    // the expired waiter has left the queue, so the mutex is unlocked
+    EXPECT_NO_THROW(executor->syncWait(waiter(mutex)));
+    // expired deadline fails fast even if the mutex is free
+    EXPECT_THROW(executor->syncWait(waiter(mutex).setDeadline(in(-1ms))), coro::DeadlineExceeded);
+    EXPECT_NO_THROW(executor->syncWait(waiter(mutex)));
+}
+
+TEST(Deadline, Latch) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Latch latch {1};
+    auto waiter = [](coro::Latch& latch) -> coro::Task<void> { co_await latch; };
+    EXPECT_THROW(executor->syncWait(waiter(latch).setDeadline(in(20ms))), coro::DeadlineExceeded);
+    latch.count_down();
+    EXPECT_NO_THROW(executor->syncWait(waiter(latch).setDeadline(in(20ms))));
+}
+
+TEST(Deadline, Semaphore) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Semaphore semaphore {0};
+    auto waiter = [](coro::Semaphore& semaphore) -> coro::Task<void> { auto permit = co_await semaphore.acquire(); };
+    auto start = coro::Deadline::clock::now();
+    EXPECT_THROW(executor->syncWait(waiter(semaphore).setDeadline(in(20ms))), coro::DeadlineExceeded);
+    EXPECT_LT(coro::Deadline::clock::now() - start, 90ms);
+    // the expired waiter has left the queue and does not take the released permit
+    semaphore.release();
+    EXPECT_EQ(semaphore.available(), 1u);
+}
+
+TEST(Deadline, Pipe) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Pipe<int> pipe;
+    auto reader = [](coro::Pipe<int>& pipe) -> coro::Task<int> { co_return co_await pipe.read(); };
+    EXPECT_THROW(executor->syncWait(reader(pipe).setDeadline(in(20ms))), coro::DeadlineExceeded);
+    // the expired reader does not consume the data
+    EXPECT_TRUE(pipe.tryWrite(5));
+    EXPECT_EQ(executor->syncWait(reader(pipe)), 5);
+}
+
+TEST(Deadline, NoThrow) {
+    auto executor = coro::SerialExecutor::create();
+    auto result = executor->syncWait([]() -> coro::Task<coro::Result<void>> {
+        co_return co_await coro::nothrow(coro::sleep(1000));
+    }().setDeadline(in(10ms)));
+    EXPECT_TRUE(result.hasError());
+    EXPECT_THROW(result.value(), coro::DeadlineExceeded);
+}
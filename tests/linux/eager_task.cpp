@@ -0,0 +1,109 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <map>
+
+/// Single threaded executor driven manually from the test, counting scheduled handles.
+class ManualExecutor : public coro::Executor {
+public:
+    static std::shared_ptr<ManualExecutor> create() {
+        return std::shared_ptr<ManualExecutor>(new ManualExecutor());
+    }
+
+    using coro::Executor::next;
+    using coro::Executor::schedule;
+
+    void schedule(coro::CoroHandle coro) override {
+        ++scheduled;
+        _tasks.push_back(std::move(coro));
+    }
+
+    void next(coro::CoroHandle coro) override {
+        ++scheduled;
+        _tasks.push_front(std::move(coro));
+    }
+
+    void external(coro::CoroHandle) override {}
+
+    void run() {
+        while (!_tasks.empty()) {
+            auto coro = std::move(_tasks.front());
+            _tasks.pop_front();
+            coro.resume();
+        }
+    }
+
+    size_t scheduled = 0;
+
+private:
+    std::deque<coro::CoroHandle> _tasks;
+};
+
+std::map<int, int> cache {{1, 10}};
+
+coro::Task<int> fetch(int key) {
+    co_return key * 10;
+}
+
+coro::EagerTask<int> load(int key) {
+    if (auto it = cache.find(key); it != cache.end()) {
+        co_return it->second;
+    }
+    co_return co_await fetch(key);
+}
+
+coro::Task<int> loadTwice(int first, int second) {
+    int result = co_await load(first);
+    result += co_await load(second);
+    co_return result;
+}
+
+TEST(EagerTask, CompletesInline) {
+    auto executor = ManualExecutor::create();
+    auto task = executor->schedule(loadTwice(1, 1));
+    executor->run();
+    EXPECT_TRUE(task.ready());
+    // only the root task was ever scheduled
+    EXPECT_EQ(executor->scheduled, 1);
+}
+
+TEST(EagerTask, Suspends) {
+    auto executor = ManualExecutor::create();
+    auto task = executor->schedule(loadTwice(1, 2));
+    executor->run();
+    EXPECT_TRUE(task.ready());
+    // root task, fetch() and the resumption of the eager task and its awaiter
+    EXPECT_EQ(executor->scheduled, 4);
+}
+
+coro::EagerTask<void> failing(bool suspend) {
+    if (suspend) {
+        co_await coro::sleep(5);
+    }
+    throw std::runtime_error("failed");
+}
+
+coro::Task<int> awaitFailing(bool suspend) {
+    try {
+        co_await failing(suspend);
+    } catch (const std::runtime_error&) {
+        co_return 1;
+    }
+    co_return 0;
+}
+
+TEST(EagerTask, Exception) {
+    auto executor = coro::SerialExecutor::create();
+    EXPECT_EQ(executor->syncWait(awaitFailing(false)), 1);
+    EXPECT_EQ(executor->syncWait(awaitFailing(true)), 1);
+}
+
+TEST(EagerTask, AsLazyTask) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Task<int> task = load(3);
+    EXPECT_EQ(executor->syncWait(std::move(task)), 30);
+}
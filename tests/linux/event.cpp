@@ -0,0 +1,73 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/event.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+coro::Task<void> waiter(coro::Event& event, std::atomic<int>& released) {
+    co_await event.wait();
+    ++released;
+}
+
+TEST(Event, SetReleasesAll) {
+    coro::Event event;
+    std::atomic<int> released = 0;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 4; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        for (int j = 0; j < 3; ++j) {
+            futures.push_back(executors.back()->future(waiter(event, released)));
+        }
+    }
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(released, 0);
+    event.set();
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(released, 12);
+}
+
+TEST(Event, Reset) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Event event {true};
+    std::atomic<int> released = 0;
+    executor->syncWait(waiter(event, released));
+    EXPECT_EQ(released, 1);
+    event.reset();
+    EXPECT_FALSE(event.isSet());
+    auto future = executor->future(waiter(event, released));
+    EXPECT_EQ(future.wait_for(20ms), std::future_status::timeout);
+    event.set();
+    future.get();
+    EXPECT_EQ(released, 2);
+}
+
+TEST(Event, WaitFor) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Event event;
+    auto timed = [](coro::Event& event, std::chrono::milliseconds timeout) -> coro::Task<bool> {
+        co_return co_await event.waitFor(timeout);
+    };
+    EXPECT_FALSE(executor->syncWait(timed(event, 10ms)));
+    auto future = executor->future(timed(event, 200ms));
+    std::this_thread::sleep_for(10ms);
+    event.set();
+    EXPECT_TRUE(future.get());
+}
+
+TEST(Event, Stop) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Event event;
+    std::atomic<int> released = 0;
+    coro::StopSource stopSource;
+    auto future = executor->future(waiter(event, released).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(10ms);
+    stopSource.requestStop();
+    EXPECT_THROW(future.get(), coro::StopError);
+    EXPECT_EQ(released, 0);
+}
@@ -0,0 +1,93 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/executors/thread_pool_executor.hpp>
+#include <coro/helpers/all.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+coro::Task<uint64_t> fib(int n) {
+    if (n < 2) {
+        co_return n;
+    }
+    auto r = co_await coro::forkJoin(fib(n - 1), fib(n - 2));
+    co_return r[0] + r[1];
+}
+
+TEST(ForkJoin, Fibonacci) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    EXPECT_EQ(pool->syncWait(fib(18)), 2584);
+    auto serial = coro::SerialExecutor::create();
+    EXPECT_EQ(serial->syncWait(fib(15)), 610);
+}
+
+coro::Task<int> number(int x) {
+    co_return x;
+}
+
+coro::Task<void> increment(std::atomic<int>& counter) {
+    ++counter;
+    co_return;
+}
+
+TEST(ForkJoin, Vector) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    std::vector<coro::Task<int>> tasks;
+    for (int i = 0; i < 100; ++i) {
+        tasks.push_back(number(i));
+    }
+    auto results = pool->syncWait(coro::forkJoin(std::move(tasks)));
+    ASSERT_EQ(results.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(results[i], i);
+    }
+
+    std::atomic<int> counter = 0;
+    std::vector<coro::Task<void>> voidTasks;
+    for (int i = 0; i < 100; ++i) {
+        voidTasks.push_back(increment(counter));
+    }
+    pool->syncWait(coro::forkJoin(std::move(voidTasks)));
+    EXPECT_EQ(counter, 100);
+
+    pool->syncWait(coro::forkJoin(increment(counter), increment(counter)));
+    EXPECT_EQ(counter, 102);
+
+    EXPECT_TRUE(pool->syncWait(coro::forkJoin(std::vector<coro::Task<int>> {})).empty());
+}
+
+struct ForkError {};
+
+coro::Task<int> failing() {
+    throw ForkError {};
+    co_return 0;
+}
+
+TEST(ForkJoin, Error) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    EXPECT_THROW(pool->syncWait(coro::forkJoin(number(1), failing(), number(2))), ForkError);
+    EXPECT_THROW(pool->syncWait(coro::forkJoin(failing(), number(1))), ForkError);
+}
+
+coro::Task<void> arriveLast(std::atomic<int>& arrived, int others) {
+    // the first child is resumed inline, and waits for the stolen ones to finish first
+    while (arrived.load() < others) {
+        std::this_thread::yield();
+    }
+    co_return;
+}
+
+coro::Task<void> arrive(std::atomic<int>& arrived) {
+    ++arrived;
+    co_return;
+}
+
+TEST(ForkJoin, FirstChildLast) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    for (int i = 0; i < 1000; ++i) {
+        std::atomic<int> arrived = 0;
+        pool->syncWait(coro::forkJoin(arriveLast(arrived, 2), arrive(arrived), arrive(arrived)));
+        EXPECT_EQ(arrived, 2);
+    }
+}
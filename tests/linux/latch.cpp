@@ -2,6 +2,7 @@
 #include <coro/sync/latch.hpp>
 #include <coro/executors/serial_executor.hpp>
 #include <coro/sleep.hpp>
+#include <coro/detail/timed_scheduler.hpp>
 
 #include <gtest/gtest.h>
 
@@ -71,3 +72,40 @@ TEST(Latch, AlreadySignaled) {
     int result = executor->syncWait(std::move(task));
     EXPECT_EQ(result, 42);
 }
+
+TEST(Latch, WaitFor) {
+    using namespace std::chrono_literals;
+    auto executor = coro::SerialExecutor::create();
+    coro::Latch latch {1};
+    auto waiter = [](coro::Latch latch, std::chrono::milliseconds timeout) -> coro::Task<bool> {
+        co_return co_await latch.waitFor(timeout);
+    };
+    EXPECT_FALSE(executor->syncWait(waiter(latch, 10ms)));
+    auto signaled = executor->future(waiter(latch, 200ms));
+    EXPECT_EQ(signaled.wait_for(20ms), std::future_status::timeout);
+    latch.count_down();
+    EXPECT_TRUE(signaled.get());
+    EXPECT_TRUE(executor->syncWait(waiter(latch, 0ms)));
+}
+
+TEST(Latch, WaitForReleasesTimeout) {
+    using namespace std::chrono_literals;
+    auto executor = coro::SerialExecutor::create();
+    coro::Latch latch {1};
+    auto waiter = [](coro::Latch latch) -> coro::Task<bool> {
+        co_return co_await latch.waitFor(10s);
+    };
+    const size_t pending = coro::detail::TimedScheduler::instance().pending();
+    std::vector<std::future<bool>> waiters;
+    for (int i = 0; i < 100; ++i) {
+        waiters.push_back(executor->future(waiter(latch)));
+    }
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(coro::detail::TimedScheduler::instance().pending(), pending + 100);
+    latch.count_down();
+    for (auto& signaled : waiters) {
+        EXPECT_TRUE(signaled.get());
+    }
+    // waits satisfied before the timeout do not keep their timeouts scheduled
+    EXPECT_EQ(coro::detail::TimedScheduler::instance().pending(), pending);
+}
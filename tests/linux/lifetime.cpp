@@ -1,4 +1,5 @@
 #include <coro/coro.hpp>
+#include <coro/helpers/all.hpp>
 #include <coro/executors/serial_executor.hpp>
 #include <coro/sleep.hpp>
 
@@ -11,6 +12,10 @@ public:
         return std::make_shared<CountingExecutor>(Tag {}, std::move(counter));
     }
 
+    static std::unique_ptr<CountingExecutor> createUnique(std::shared_ptr<std::atomic<size_t>> counter) {
+        return std::make_unique<CountingExecutor>(Tag {}, std::move(counter));
+    }
+
 protected:
     using Tag = coro::SerialExecutor::Tag;
 
@@ -77,3 +82,22 @@ TEST(NoReference, Lifetime) {
     EXPECT_EQ(*counter, 0); // executor was destroyed
     EXPECT_EQ(result, 42);
 }
+
+coro::Task<bool> sharedExecutor() {
+    auto executor = co_await coro::currentExecutor;
+    co_await coro::all(foo<1>(false), foo<2>(false), foo<3>(false));
+    co_return executor != nullptr;
+}
+
+TEST(NotShared, Lifetime) {
+    auto counter = std::make_shared<std::atomic<size_t>>(0);
+    {
+        // executor owned by its user instead of shared_ptr
+        auto executor = CountingExecutor::createUnique(counter);
+        EXPECT_FALSE(executor->syncWait(sharedExecutor()));
+        EXPECT_EQ(*counter, 1);
+    }
+    EXPECT_EQ(*counter, 0);
+    auto executor = CountingExecutor::create(counter);
+    EXPECT_TRUE(executor->syncWait(sharedExecutor()));
+}
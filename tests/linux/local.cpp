@@ -0,0 +1,44 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+const coro::LocalKey<std::string> requestId;
+const coro::LocalKey<int> attempt;
+const coro::LocalKey<int> unused;
+
+coro::Task<std::string> describe() {
+    const std::string* id = co_await coro::local(requestId);
+    const int* n = co_await coro::local(attempt);
+    const int* missing = co_await coro::local(unused);
+    EXPECT_EQ(missing, nullptr);
+    co_return (id ? *id : "none") + ":" + (n ? std::to_string(*n) : "none");
+}
+
+coro::Task<std::string> nested() {
+    co_return co_await describe();
+}
+
+TEST(Local, Inheritance) {
+    auto executor = coro::SerialExecutor::create();
+    EXPECT_EQ(executor->syncWait(describe()), "none:none");
+    auto result = executor->syncWait([]() -> coro::Task<std::vector<std::string>> {
+        std::vector<std::string> results;
+        results.push_back(co_await nested());
+        // values set on the child are kept on top of the inherited ones
+        results.push_back(co_await nested().setLocal(attempt, 2));
+        results.push_back(co_await nested().setLocal(requestId, "other"));
+        results.push_back(co_await nested());
+        co_return results;
+    }().setLocal(requestId, "request").setLocal(attempt, 1));
+    EXPECT_EQ(result, (std::vector<std::string> {"request:1", "request:2", "other:1", "request:1"}));
+}
+
+TEST(Local, Task) {
+    auto task = describe().setLocal(attempt, 3);
+    EXPECT_EQ(*task.local(attempt), 3);
+    EXPECT_EQ(task.local(requestId), nullptr);
+    EXPECT_EQ(task.local(unused), nullptr);
+}
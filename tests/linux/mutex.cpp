@@ -27,3 +27,109 @@ TEST(Mutex, CrossExecutorDataRace) {
     }
     EXPECT_EQ(counter, 10000);
 }
+
+TEST(Mutex, BargingCrossExecutorDataRace) {
+    coro::Mutex mutex {coro::Mutex::Mode::Barging};
+    size_t counter = 0;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 10; ++i) {
+        auto task = advance(counter, mutex);
+        auto executor = coro::SerialExecutor::create();
+        futures.push_back(executor->future(std::move(task)));
+    }
+    for (auto& future : futures) {
+        future.wait();
+    }
+    EXPECT_EQ(counter, 10000);
+}
+
+coro::Task<void> record(coro::Mutex& mutex, int id, std::vector<int>& order) {
+    auto lock = co_await mutex;
+    order.push_back(id);
+}
+
+TEST(Mutex, FifoOrder) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    std::vector<int> order;
+    auto holder = executor->future([](coro::Mutex& mutex) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await coro::sleep(20);
+    }(mutex));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    std::vector<std::future<void>> futures;
+    for (int id = 0; id < 5; ++id) {
+        futures.push_back(executor->future(record(mutex, id, order)));
+    }
+    holder.get();
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector {0, 1, 2, 3, 4}));
+}
+
+TEST(Mutex, BargingStop) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex {coro::Mutex::Mode::Barging};
+    std::vector<int> order;
+    auto holder = executor->future([](coro::Mutex& mutex) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await coro::sleep(20);
+    }(mutex));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    coro::StopSource stopSource;
+    auto stopped = executor->future(record(mutex, 1, order).setStopToken(stopSource.token()));
+    auto waiting = executor->future(record(mutex, 2, order));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    stopSource.requestStop();
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    holder.get();
+    waiting.get();
+    EXPECT_EQ(order, (std::vector {2}));
+}
+
+TEST(Mutex, StopRemovesWaiter) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Mutex mutex;
+    std::vector<int> order;
+    auto holder = executor->future([](coro::Mutex& mutex) -> coro::Task<void> {
+        auto lock = co_await mutex;
+        co_await coro::sleep(50);
+    }(mutex));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    coro::StopSource stopSource;
+    auto stopped = executor->future(record(mutex, 1, order).setStopToken(stopSource.token()));
+    auto waiting = executor->future(record(mutex, 2, order));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    stopSource.requestStop();
+    // woken up right away, not when the holder unlocks
+    EXPECT_EQ(stopped.wait_for(std::chrono::milliseconds {30}), std::future_status::ready);
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    holder.get();
+    waiting.get();
+    EXPECT_EQ(order, (std::vector {2}));
+}
+
+TEST(Mutex, LockFor) {
+    using namespace std::chrono_literals;
+    auto executor = coro::SerialExecutor::create();
+    for (auto mode : {coro::Mutex::Mode::Fifo, coro::Mutex::Mode::Barging}) {
+        coro::Mutex mutex {mode};
+        auto holder = executor->future([](coro::Mutex& mutex) -> coro::Task<void> {
+            auto lock = co_await mutex;
+            co_await coro::sleep(50);
+        }(mutex));
+        std::this_thread::sleep_for(5ms);
+        auto waiter = [](coro::Mutex& mutex, std::chrono::milliseconds timeout) -> coro::Task<bool> {
+            auto lock = co_await mutex.lockFor(timeout);
+            co_return lock.has_value();
+        };
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(executor->syncWait(waiter(mutex, 10ms)));
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 40ms);
+        EXPECT_TRUE(executor->syncWait(waiter(mutex, 200ms)));
+        holder.get();
+        // the timed out waiter has left the queue, so the mutex is unlocked
+        EXPECT_TRUE(executor->syncWait(waiter(mutex, 0ms)));
+    }
+}
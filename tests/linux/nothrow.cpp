@@ -0,0 +1,94 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/nothrow.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/mutex.hpp>
+#include <coro/sync/pipe.hpp>
+
+#include <gtest/gtest.h>
+
+coro::Task<int> value(int x) {
+    co_return x;
+}
+
+coro::Task<int> failing() {
+    throw std::runtime_error("failed");
+    co_return 0;
+}
+
+TEST(NoThrow, Value) {
+    auto executor = coro::SerialExecutor::create();
+    auto result = executor->syncWait([]() -> coro::Task<coro::Result<int>> {
+        co_return co_await coro::nothrow(value(42));
+    }());
+    EXPECT_TRUE(result.hasValue());
+    EXPECT_EQ(result.value(), 42);
+    EXPECT_EQ(result.error(), nullptr);
+}
+
+TEST(NoThrow, Error) {
+    auto executor = coro::SerialExecutor::create();
+    auto result = executor->syncWait([]() -> coro::Task<coro::Result<int>> {
+        co_return co_await coro::nothrow(failing());
+    }());
+    EXPECT_TRUE(result.hasError());
+    EXPECT_NE(result.error(), nullptr);
+    EXPECT_THROW(result.value(), std::runtime_error);
+}
+
+coro::Task<coro::Result<int>> sleeper(std::atomic<int>& stopped) {
+    auto slept = co_await coro::nothrow(coro::sleep(1000));
+    if (slept.isStopped()) {
+        ++stopped;
+        co_return coro::Result<int>::stopped();
+    }
+    co_return 1;
+}
+
+TEST(NoThrow, Stopped) {
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    std::atomic<int> stopped = 0;
+    coro::TaskContext context;
+    context.stopToken = stopSource.token();
+    std::vector<std::future<coro::Result<int>>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(executor->future(sleeper(stopped).setContext(context)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds {20});
+    stopSource.requestStop();
+    for (auto& future : futures) {
+        EXPECT_TRUE(future.get().isStopped());
+    }
+    EXPECT_EQ(stopped, 100);
+}
+
+TEST(NoThrow, StoppedTask) {
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    std::atomic<int> stopped = 0;
+    coro::TaskContext context;
+    context.stopToken = stopSource.token();
+    auto future = executor->future([](std::atomic<int>& stopped) -> coro::Task<bool> {
+        // Result returned by the task is unwrapped
+        coro::Result<int> result = co_await coro::nothrow(sleeper(stopped));
+        co_return result.isStopped();
+    }(stopped).setContext(context));
+    std::this_thread::sleep_for(std::chrono::milliseconds {20});
+    stopSource.requestStop();
+    EXPECT_TRUE(future.get());
+}
+
+TEST(NoThrow, Primitives) {
+    auto executor = coro::SerialExecutor::create();
+    auto result = executor->syncWait([]() -> coro::Task<int> {
+        coro::Mutex mutex;
+        auto lock = co_await coro::nothrow(mutex);
+        EXPECT_TRUE(lock.hasValue());
+        coro::Pipe<int> pipe;
+        co_await pipe.write(5);
+        auto data = co_await coro::nothrow(pipe.read());
+        co_return data.value();
+    }());
+    EXPECT_EQ(result, 5);
+}
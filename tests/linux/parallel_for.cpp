@@ -0,0 +1,101 @@
+#include <coro/coro.hpp>
+#include <coro/executors/executor_group.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/parallel_for.hpp>
+
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST(ParallelFor, VisitsEachIndexOnce) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(4);
+    auto executor = coro::SerialExecutor::create();
+    for (size_t grain : {size_t {0}, size_t {1}, size_t {7}, size_t {1000}}) {
+        std::vector<std::atomic<int>> visits(1000);
+        executor->syncWait(coro::parallelFor(group, size_t {0}, visits.size(), grain, [&](size_t i) { ++visits[i]; }));
+        for (auto& v : visits) {
+            EXPECT_EQ(v, 1);
+        }
+    }
+}
+
+TEST(ParallelFor, RunsOnGroupExecutors) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(4);
+    auto executor = coro::SerialExecutor::create();
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto task = coro::parallelFor(group, 0, 64, 1, [&](int) {
+        std::this_thread::sleep_for(std::chrono::milliseconds {1});
+        std::scoped_lock lock {mutex};
+        threads.insert(std::this_thread::get_id());
+    });
+    executor->syncWait(std::move(task));
+    EXPECT_GT(threads.size(), 1);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0);
+}
+
+TEST(ParallelFor, EmptyRange) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(2);
+    auto executor = coro::SerialExecutor::create();
+    int calls = 0;
+    executor->syncWait(coro::parallelFor(group, 10, 10, 0, [&](int) { ++calls; }));
+    executor->syncWait(coro::parallelFor(group, 10, 5, 0, [&](int) { ++calls; }));
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(ParallelFor, Reduce) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(3);
+    auto executor = coro::SerialExecutor::create();
+    auto square = [](int64_t i) { return i * i; };
+    int64_t expected = 0;
+    for (int64_t i = -50; i < 1000; ++i) {
+        expected += i * i;
+    }
+    for (int64_t grain : {0, 1, 64}) {
+        auto task = coro::parallelReduce(group, int64_t {-50}, int64_t {1000}, grain, int64_t {0}, square, std::plus<> {});
+        EXPECT_EQ(executor->syncWait(std::move(task)), expected);
+    }
+}
+
+struct ParallelError {};
+
+TEST(ParallelFor, Error) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(4);
+    auto executor = coro::SerialExecutor::create();
+    std::atomic<int> calls = 0;
+    auto task = coro::parallelFor(group, 0, 100000, 1, [&](int i) {
+        ++calls;
+        if (i == 10) {
+            throw ParallelError {};
+        }
+    });
+    EXPECT_THROW(executor->syncWait(std::move(task)), ParallelError);
+    EXPECT_LT(calls, 100000);
+}
+
+TEST(ParallelFor, Cancellation) {
+    auto group = coro::ExecutorGroup::create<coro::SerialExecutor>(2);
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    std::atomic<int> calls = 0;
+    auto task = coro::parallelFor(group, 0, 1000, 1, [&](int) {
+        if (++calls == 10) {
+            stopSource.requestStop();
+        }
+    });
+    task.setStopToken(stopSource.token());
+    EXPECT_THROW(executor->syncWait(std::move(task)), coro::StopError);
+    EXPECT_LT(calls, 1000);
+}
+
+TEST(ParallelFor, EmptyGroup) {
+    coro::ExecutorGroup group {std::vector<coro::Executor::Ref> {}};
+    auto executor = coro::SerialExecutor::create();
+    int calls = 0;
+    EXPECT_THROW(executor->syncWait(coro::parallelFor(group, 0, 10, 0, [&](int) { ++calls; })), std::invalid_argument);
+    auto reduce = coro::parallelReduce(group, 0, 10, 0, 0, [](int i) { return i; }, std::plus<> {});
+    EXPECT_THROW(executor->syncWait(std::move(reduce)), std::invalid_argument);
+    EXPECT_EQ(calls, 0);
+}
@@ -13,9 +13,9 @@ coro::Task<int> consumer(coro::Pipe<int>& pipe) {
 
 coro::Task<void> producer(coro::Pipe<int>& pipe) {
     co_await coro::sleep(50);
-    pipe.write(11);
+    co_await pipe.write(11);
     co_await coro::sleep(50);
-    pipe.write(22);
+    co_await pipe.write(22);
 }
 
 TEST(Pipe, Simple) {
@@ -25,3 +25,165 @@ TEST(Pipe, Simple) {
     int result = executor->syncWait(consumer(pipe));
     EXPECT_EQ(result, 33);
 }
+
+coro::Task<void> produceAll(coro::Pipe<int>& pipe, int count, std::atomic<int>& written) {
+    for (int i = 0; i < count; ++i) {
+        co_await pipe.write(i);
+        ++written;
+    }
+}
+
+TEST(Pipe, Bounded) {
+    coro::Pipe<int> pipe {2};
+    std::atomic<int> written = 0;
+    auto producerExecutor = coro::SerialExecutor::create();
+    auto producing = producerExecutor->future(produceAll(pipe, 10, written));
+    std::this_thread::sleep_for(std::chrono::milliseconds {20});
+    // the producer is suspended while the pipe is full
+    EXPECT_EQ(written, 2);
+    EXPECT_FALSE(pipe.tryWrite(100));
+    auto consumerExecutor = coro::SerialExecutor::create();
+    auto values = consumerExecutor->syncWait([](coro::Pipe<int>& pipe) -> coro::Task<std::vector<int>> {
+        std::vector<int> values;
+        for (int i = 0; i < 10; ++i) {
+            values.push_back(co_await pipe.read());
+        }
+        co_return values;
+    }(pipe));
+    producing.get();
+    EXPECT_EQ(values, (std::vector {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    EXPECT_FALSE(pipe.tryRead().has_value());
+}
+
+TEST(Pipe, Rendezvous) {
+    coro::Pipe<int> pipe {0};
+    EXPECT_FALSE(pipe.tryWrite(1));
+    std::atomic<int> written = 0;
+    auto executor = coro::SerialExecutor::create();
+    auto producing = executor->future(produceAll(pipe, 3, written));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    EXPECT_EQ(written, 0);
+    // the data is taken right from the suspended writer
+    EXPECT_EQ(pipe.tryRead(), 0);
+    EXPECT_EQ(executor->syncWait(consumer(pipe)), 3);
+    producing.get();
+    EXPECT_EQ(written, 3);
+}
+
+TEST(Pipe, StopRemovesWriter) {
+    coro::Pipe<int> pipe {1};
+    EXPECT_TRUE(pipe.tryWrite(1));
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    auto writer = [](coro::Pipe<int>& pipe, int value) -> coro::Task<void> { co_await pipe.write(value); };
+    auto stopped = executor->future(writer(pipe, 2).setStopToken(stopSource.token()));
+    auto waiting = executor->future(writer(pipe, 3));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    stopSource.requestStop();
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    EXPECT_EQ(pipe.tryRead(), 1);
+    waiting.get();
+    EXPECT_EQ(pipe.tryRead(), 3);
+}
+
+TEST(Pipe, Batched) {
+    coro::Pipe<int> pipe {4};
+    std::vector<int> items {1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(pipe.writeMany(items), 4);
+    auto executor = coro::SerialExecutor::create();
+    auto reader = [](coro::Pipe<int>& pipe, size_t count) -> coro::Task<std::vector<int>> {
+        co_return co_await pipe.readMany(count);
+    };
+    EXPECT_EQ(executor->syncWait(reader(pipe, 3)), (std::vector {1, 2, 3}));
+    EXPECT_EQ(pipe.writeMany(std::span {items}.subspan(4)), 2);
+    EXPECT_EQ(executor->syncWait(reader(pipe, 10)), (std::vector {4, 5, 6}));
+    // suspends till at least one item is available
+    auto waiting = executor->future(reader(pipe, 10));
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds {10}), std::future_status::timeout);
+    std::vector<int> more {7, 8, 9};
+    EXPECT_EQ(pipe.writeMany(more), 3);
+    EXPECT_EQ(waiting.get(), (std::vector {7, 8, 9}));
+}
+
+TEST(Pipe, BatchedReadersWokenTogether) {
+    coro::Pipe<int> pipe;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<int>> readers;
+    for (int i = 0; i < 3; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        readers.push_back(executors.back()->future([](coro::Pipe<int>& pipe) -> coro::Task<int> {
+            co_return co_await pipe.read();
+        }(pipe)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    std::vector<int> items {1, 2, 3};
+    EXPECT_EQ(pipe.writeMany(items), 3);
+    int sum = 0;
+    for (auto& reader : readers) {
+        sum += reader.get();
+    }
+    EXPECT_EQ(sum, 6);
+}
+
+TEST(Pipe, Close) {
+    coro::Pipe<int> pipe;
+    auto executor = coro::SerialExecutor::create();
+    auto drain = [](coro::Pipe<int>& pipe) -> coro::Task<int> {
+        int sum = 0;
+        while (auto data = co_await pipe.next()) {
+            sum += *data;
+        }
+        co_return sum;
+    };
+    auto draining = executor->future(drain(pipe));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    EXPECT_TRUE(pipe.tryWrite(1));
+    EXPECT_TRUE(pipe.tryWrite(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    // wakes the reader suspended on the empty pipe
+    pipe.close();
+    EXPECT_TRUE(pipe.closed());
+    EXPECT_EQ(draining.get(), 3);
+    EXPECT_FALSE(pipe.tryWrite(3));
+    EXPECT_THROW(executor->syncWait([](coro::Pipe<int>& pipe) -> coro::Task<void> { co_await pipe.read(); }(pipe)),
+                 coro::PipeClosed);
+    EXPECT_TRUE(executor->syncWait([](coro::Pipe<int>& pipe) -> coro::Task<std::vector<int>> {
+                            co_return co_await pipe.readMany(10);
+                        }(pipe))
+                    .empty());
+}
+
+TEST(Pipe, CloseDrainsBuffer) {
+    coro::Pipe<int> pipe {1};
+    EXPECT_TRUE(pipe.tryWrite(1));
+    auto executor = coro::SerialExecutor::create();
+    auto writing = executor->future([](coro::Pipe<int>& pipe) -> coro::Task<void> {
+        co_await pipe.write(2);
+    }(pipe));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    pipe.close();
+    // the suspended writer fails, while the buffered data is still delivered
+    EXPECT_THROW(writing.get(), coro::PipeClosed);
+    std::vector<int> values;
+    executor->syncWait(coro::forEach(pipe, [&](int value) { values.push_back(value); }));
+    EXPECT_EQ(values, (std::vector {1}));
+}
+
+TEST(Pipe, ForEach) {
+    coro::Pipe<int> pipe {2};
+    auto consumerExecutor = coro::SerialExecutor::create();
+    int sum = 0;
+    auto consuming = consumerExecutor->future(coro::forEach(pipe, [&](int value) -> coro::Task<void> {
+        co_await coro::sleep(1);
+        sum += value;
+    }));
+    auto producerExecutor = coro::SerialExecutor::create();
+    producerExecutor->syncWait([](coro::Pipe<int>& pipe) -> coro::Task<void> {
+        for (int i = 1; i <= 10; ++i) {
+            co_await pipe.write(i);
+        }
+        pipe.close();
+    }(pipe));
+    consuming.get();
+    EXPECT_EQ(sum, 55);
+}
@@ -0,0 +1,118 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+
+#include <gtest/gtest.h>
+
+struct Counters {
+    int copies = 0;
+    int moves = 0;
+};
+
+Counters counters;
+
+struct Heavy {
+    Heavy(int v = 0)
+        : value(v) {}
+
+    Heavy(const Heavy& other)
+        : value(other.value) {
+        ++counters.copies;
+    }
+
+    Heavy(Heavy&& other)
+        : value(other.value) {
+        ++counters.moves;
+    }
+
+    Heavy& operator=(const Heavy& other) {
+        value = other.value;
+        ++counters.copies;
+        return *this;
+    }
+
+    Heavy& operator=(Heavy&& other) {
+        value = other.value;
+        ++counters.moves;
+        return *this;
+    }
+
+    int value;
+};
+
+coro::Task<Heavy> makeHeavy(int value) {
+    co_return Heavy {value};
+}
+
+coro::Task<Heavy> makeHeavyInPlace(int value) {
+    co_return value;
+}
+
+TEST(ResultTransfer, Value) {
+    auto executor = coro::SerialExecutor::create();
+    counters = {};
+    auto value = executor->syncWait([]() -> coro::Task<int> {
+        Heavy heavy = co_await makeHeavy(1);
+        Heavy inPlace = co_await makeHeavyInPlace(2);
+        co_return heavy.value + inPlace.value;
+    }());
+    EXPECT_EQ(value, 3);
+    EXPECT_EQ(counters.copies, 0);
+    // one move into the promise for the temporary and one move out of the promise for each task
+    EXPECT_EQ(counters.moves, 3);
+}
+
+int global = 0;
+
+coro::Task<int&> reference() {
+    co_return global;
+}
+
+coro::Task<const int&> constReference() {
+    co_return global;
+}
+
+TEST(ResultTransfer, Reference) {
+    auto executor = coro::SerialExecutor::create();
+    executor->syncWait([]() -> coro::Task<void> {
+        int& ref = co_await reference();
+        EXPECT_EQ(&ref, &global);
+        ref = 5;
+        const int& cref = co_await constReference();
+        EXPECT_EQ(&cref, &global);
+        EXPECT_EQ(cref, 5);
+    }());
+}
+
+struct NoDefault {
+    explicit NoDefault(int v)
+        : value(v) {}
+
+    int value;
+};
+
+TEST(ResultTransfer, NoDefaultConstructor) {
+    auto executor = coro::SerialExecutor::create();
+    auto result = executor->syncWait([]() -> coro::Task<NoDefault> { co_return NoDefault {7}; }());
+    EXPECT_EQ(result.value, 7);
+}
+
+TEST(ResultTransfer, All) {
+    auto executor = coro::SerialExecutor::create();
+    counters = {};
+    auto results = executor->syncWait([]() -> coro::Task<std::vector<int>> {
+        std::vector<coro::Task<Heavy>> tasks;
+        for (int i = 0; i < 3; ++i) {
+            tasks.push_back(makeHeavyInPlace(i));
+        }
+        std::vector<Heavy> heavy = co_await coro::all(std::move(tasks));
+        std::vector<int> values;
+        for (auto& h : heavy) {
+            values.push_back(h.value);
+        }
+        co_return values;
+    }());
+    EXPECT_EQ(results, (std::vector {0, 1, 2}));
+    EXPECT_EQ(counters.copies, 0);
+    // every result is assigned once right into the results vector
+    EXPECT_EQ(counters.moves, 3);
+}
@@ -0,0 +1,71 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/resume_on.hpp>
+#include <coro/sleep.hpp>
+
+#include <gtest/gtest.h>
+
+std::thread::id executorThread(const coro::SerialExecutor::Ref& executor) {
+    return executor->syncWait([]() -> coro::Task<std::thread::id> { co_return std::this_thread::get_id(); }());
+}
+
+coro::Task<std::thread::id> currentThread() {
+    co_return std::this_thread::get_id();
+}
+
+coro::Task<int> bounce(coro::Executor::Ref io, coro::Executor::Ref cpu, std::vector<std::thread::id>& threads) {
+    threads.push_back(std::this_thread::get_id());
+    co_await coro::resumeOn(cpu);
+    threads.push_back(std::this_thread::get_id());
+    EXPECT_EQ(co_await coro::currentExecutor, cpu);
+    // child tasks inherit the new executor
+    threads.push_back(co_await currentThread());
+    co_await coro::sleep(10);
+    threads.push_back(std::this_thread::get_id());
+    co_await coro::resumeOn(io);
+    threads.push_back(std::this_thread::get_id());
+    co_return 42;
+}
+
+TEST(ResumeOn, Bounce) {
+    auto io = coro::SerialExecutor::create();
+    auto cpu = coro::SerialExecutor::create();
+    const auto ioThread = executorThread(io);
+    const auto cpuThread = executorThread(cpu);
+
+    std::vector<std::thread::id> threads;
+    EXPECT_EQ(io->syncWait(bounce(io, cpu, threads)), 42);
+    EXPECT_EQ(threads, (std::vector {ioThread, cpuThread, cpuThread, cpuThread, ioThread}));
+}
+
+coro::Task<std::thread::id> resumeOnOther(coro::Executor::Ref other) {
+    co_await coro::resumeOn(other);
+    co_return std::this_thread::get_id();
+}
+
+coro::Task<std::vector<std::thread::id>> awaiter(coro::Executor::Ref other) {
+    std::vector<std::thread::id> threads;
+    threads.push_back(co_await resumeOnOther(other));
+    // awaiter stays on its own executor after the child has moved
+    threads.push_back(std::this_thread::get_id());
+    co_return threads;
+}
+
+TEST(ResumeOn, ChildMigration) {
+    auto first = coro::SerialExecutor::create();
+    auto second = coro::SerialExecutor::create();
+    auto threads = first->syncWait(awaiter(second));
+    EXPECT_EQ(threads, (std::vector {executorThread(second), executorThread(first)}));
+}
+
+coro::Task<void> sameExecutor() {
+    auto executor = co_await coro::currentExecutor;
+    auto thread = std::this_thread::get_id();
+    co_await coro::resumeOn(executor);
+    EXPECT_EQ(thread, std::this_thread::get_id());
+}
+
+TEST(ResumeOn, SameExecutor) {
+    auto executor = coro::SerialExecutor::create();
+    executor->syncWait(sameExecutor());
+}
@@ -0,0 +1,97 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/all.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/ring_pipe.hpp>
+
+#include <gtest/gtest.h>
+
+constexpr int Items = 5'000;
+
+template <typename Pipe>
+coro::Task<void> produce(Pipe& pipe, int from, int count) {
+    for (int i = from; i < from + count; ++i) {
+        co_await pipe.write(i);
+    }
+}
+
+TEST(RingPipe, SpscOrder) {
+    coro::SpscPipe<int> pipe {16};
+    EXPECT_EQ(pipe.capacity(), 16);
+    auto producer = coro::SerialExecutor::create();
+    auto consumer = coro::SerialExecutor::create();
+    auto producing = producer->future(produce(pipe, 0, Items));
+    auto mismatches = consumer->syncWait([](coro::SpscPipe<int>& pipe) -> coro::Task<int> {
+        int mismatches = 0;
+        for (int i = 0; i < Items; ++i) {
+            if (co_await pipe.read() != i) {
+                ++mismatches;
+            }
+        }
+        co_return mismatches;
+    }(pipe));
+    producing.get();
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_FALSE(pipe.tryRead().has_value());
+}
+
+TEST(RingPipe, MpmcSum) {
+    coro::MpmcPipe<int> pipe {8};
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<void>> producers;
+    std::vector<std::future<int64_t>> consumers;
+    for (int i = 0; i < 4; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        producers.push_back(executors.back()->future(produce(pipe, i * Items, Items)));
+        executors.push_back(coro::SerialExecutor::create());
+        consumers.push_back(executors.back()->future([](coro::MpmcPipe<int>& pipe) -> coro::Task<int64_t> {
+            int64_t sum = 0;
+            for (int i = 0; i < Items; ++i) {
+                sum += co_await pipe.read();
+            }
+            co_return sum;
+        }(pipe)));
+    }
+    for (auto& producer : producers) {
+        producer.get();
+    }
+    int64_t sum = 0;
+    for (auto& consumer : consumers) {
+        sum += consumer.get();
+    }
+    const int64_t total = 4 * Items;
+    EXPECT_EQ(sum, total * (total - 1) / 2);
+}
+
+TEST(RingPipe, Full) {
+    coro::MpmcPipe<std::string> pipe {2};
+    EXPECT_TRUE(pipe.tryWrite("a"));
+    EXPECT_TRUE(pipe.tryWrite("b"));
+    std::string data = "c";
+    EXPECT_FALSE(pipe.tryWrite(std::move(data)));
+    // the data is not consumed by the failed attempt
+    EXPECT_EQ(data, "c");
+    auto executor = coro::SerialExecutor::create();
+    auto writer = executor->future([](coro::MpmcPipe<std::string>& pipe) -> coro::Task<void> {
+        co_await pipe.write("c");
+    }(pipe));
+    EXPECT_EQ(writer.wait_for(std::chrono::milliseconds {10}), std::future_status::timeout);
+    EXPECT_EQ(pipe.tryRead(), "a");
+    writer.get();
+    EXPECT_EQ(pipe.tryRead(), "b");
+    EXPECT_EQ(pipe.tryRead(), "c");
+}
+
+TEST(RingPipe, StopRemovesReader) {
+    coro::SpscPipe<int> pipe {4};
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    auto reader = [](coro::SpscPipe<int>& pipe) -> coro::Task<int> { co_return co_await pipe.read(); };
+    auto stopped = executor->future(reader(pipe).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    stopSource.requestStop();
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    // the stopped reader does not consume the data
+    EXPECT_TRUE(pipe.tryWrite(5));
+    EXPECT_EQ(executor->syncWait(reader(pipe)), 5);
+}
@@ -0,0 +1,96 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/select.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using Selected = std::variant<int, std::string, std::monostate>;
+
+coro::Task<Selected> selectOne(coro::Pipe<int>& numbers, coro::Pipe<std::string>& strings, uint32_t timeout) {
+    co_return co_await coro::select(numbers.read(), strings.read(), coro::sleep(timeout));
+}
+
+TEST(Select, Available) {
+    coro::Pipe<int> numbers;
+    coro::Pipe<std::string> strings;
+    EXPECT_TRUE(strings.tryWrite("a"));
+    EXPECT_TRUE(numbers.tryWrite(1));
+    auto executor = coro::SerialExecutor::create();
+    // the first available source in the order of the arguments
+    auto first = executor->syncWait(selectOne(numbers, strings, 300));
+    EXPECT_EQ(first, Selected {1});
+    auto second = executor->syncWait(selectOne(numbers, strings, 300));
+    EXPECT_EQ(second, Selected {std::string {"a"}});
+    auto timeout = executor->syncWait(selectOne(numbers, strings, 10));
+    EXPECT_EQ(timeout.index(), 2);
+}
+
+TEST(Select, Suspended) {
+    coro::Pipe<int> numbers;
+    coro::Pipe<std::string> strings;
+    auto executor = coro::SerialExecutor::create();
+    auto selecting = executor->future(selectOne(numbers, strings, 300));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    EXPECT_TRUE(strings.tryWrite("b"));
+    EXPECT_EQ(selecting.get(), Selected {std::string {"b"}});
+    // the reader is removed from the other pipe, so the data goes into the buffer
+    EXPECT_TRUE(numbers.tryWrite(2));
+    EXPECT_EQ(numbers.tryRead(), 2);
+}
+
+TEST(Select, NoLostItems) {
+    constexpr int Items = 2000;
+    coro::Pipe<int> first;
+    coro::Pipe<int> second;
+    auto consumerExecutor = coro::SerialExecutor::create();
+    auto consuming = consumerExecutor->future([](coro::Pipe<int>& first, coro::Pipe<int>& second) -> coro::Task<int> {
+        int sum = 0;
+        for (int i = 0; i < 2 * Items; ++i) {
+            auto selected = co_await coro::select(first.read(), second.read());
+            sum += selected.index() == 0 ? std::get<0>(selected) : std::get<1>(selected);
+        }
+        co_return sum;
+    }(first, second));
+    auto produce = [](coro::Pipe<int>& pipe) -> coro::Task<void> {
+        for (int i = 1; i <= Items; ++i) {
+            co_await pipe.write(i);
+        }
+    };
+    auto firstExecutor = coro::SerialExecutor::create();
+    auto secondExecutor = coro::SerialExecutor::create();
+    auto firstProducing = firstExecutor->future(produce(first));
+    auto secondProducing = secondExecutor->future(produce(second));
+    firstProducing.get();
+    secondProducing.get();
+    EXPECT_EQ(consuming.get(), Items * (Items + 1));
+}
+
+TEST(Select, Closed) {
+    coro::Pipe<int> data;
+    coro::Pipe<int> control;
+    auto executor = coro::SerialExecutor::create();
+    auto selecting = executor->future([](coro::Pipe<int>& data, coro::Pipe<int>& control) -> coro::Task<size_t> {
+        auto selected = co_await coro::select(data.read(), control.next());
+        EXPECT_FALSE(std::get<1>(selected).has_value());
+        co_return selected.index();
+    }(data, control));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    control.close();
+    EXPECT_EQ(selecting.get(), 1);
+}
+
+TEST(Select, Stop) {
+    coro::Pipe<int> numbers;
+    coro::Pipe<std::string> strings;
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource stopSource;
+    auto selecting = executor->future(selectOne(numbers, strings, 300).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    stopSource.requestStop();
+    EXPECT_THROW(selecting.get(), coro::StopError);
+    EXPECT_TRUE(numbers.tryWrite(1));
+    EXPECT_EQ(numbers.tryRead(), 1);
+}
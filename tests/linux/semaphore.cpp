@@ -0,0 +1,116 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/nothrow.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/semaphore.hpp>
+
+#include <gtest/gtest.h>
+
+coro::Task<void> limited(coro::Semaphore& semaphore, std::atomic<int>& inside, std::atomic<int>& maxInside) {
+    for (int i = 0; i < 20; ++i) {
+        auto permit = co_await semaphore.acquire();
+        int current = ++inside;
+        int max = maxInside.load();
+        while (current > max && !maxInside.compare_exchange_weak(max, current)) {
+        }
+        co_await coro::sleep(1);
+        --inside;
+    }
+}
+
+TEST(Semaphore, Limit) {
+    coro::Semaphore semaphore {3};
+    std::atomic<int> inside = 0;
+    std::atomic<int> maxInside = 0;
+    std::vector<std::future<void>> futures;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    for (int i = 0; i < 10; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        futures.push_back(executors.back()->future(limited(semaphore, inside, maxInside)));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_LE(maxInside, 3);
+    EXPECT_EQ(semaphore.available(), 3);
+}
+
+TEST(Semaphore, TryAcquire) {
+    coro::Semaphore semaphore {2};
+    auto first = semaphore.tryAcquire(2);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->count(), 2);
+    EXPECT_FALSE(semaphore.tryAcquire().has_value());
+    first->reset();
+    EXPECT_EQ(semaphore.available(), 2);
+    {
+        auto second = semaphore.tryAcquire();
+        EXPECT_EQ(semaphore.available(), 1);
+    }
+    EXPECT_EQ(semaphore.available(), 2);
+}
+
+coro::Task<void> weighted(coro::Semaphore& semaphore, size_t count, std::vector<size_t>& order) {
+    auto permit = co_await semaphore.acquire(count);
+    order.push_back(count);
+}
+
+TEST(Semaphore, WeightedFifo) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Semaphore semaphore {4};
+    std::vector<size_t> order;
+    auto permit = semaphore.tryAcquire(4);
+    // the large request is queued first, so the small ones must not overtake it
+    std::vector<std::future<void>> futures;
+    for (size_t count : {3, 1, 2}) {
+        futures.push_back(executor->future(weighted(semaphore, count, order)));
+        std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    }
+    EXPECT_FALSE(semaphore.tryAcquire().has_value());
+    permit->reset();
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector<size_t> {3, 1, 2}));
+    EXPECT_EQ(semaphore.available(), 4);
+}
+
+TEST(Semaphore, StopRemovesWaiter) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Semaphore semaphore {1};
+    auto permit = semaphore.tryAcquire();
+    coro::StopSource stopSource;
+    std::atomic<bool> acquired = false;
+    auto acquire = [](coro::Semaphore& semaphore, size_t count, std::atomic<bool>& acquired) -> coro::Task<void> {
+        auto permit = co_await semaphore.acquire(count);
+        acquired = true;
+    };
+    // the stopped head of the queue should not block the waiters behind it
+    auto stopped = executor->future(acquire(semaphore, 2, acquired).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    auto waiting = executor->future(acquire(semaphore, 1, acquired));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    permit->reset();
+    EXPECT_FALSE(acquired);
+    stopSource.requestStop();
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    waiting.get();
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ(semaphore.available(), 1);
+}
+
+TEST(Semaphore, NoThrow) {
+    auto executor = coro::SerialExecutor::create();
+    coro::Semaphore semaphore {1};
+    auto permit = semaphore.tryAcquire();
+    coro::StopSource stopSource;
+    auto future = executor->future([](coro::Semaphore& semaphore) -> coro::Task<bool> {
+        auto result = co_await coro::nothrow(semaphore.acquire());
+        co_return result.isStopped();
+    }(semaphore).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {10});
+    stopSource.requestStop();
+    EXPECT_TRUE(future.get());
+    permit.reset();
+    EXPECT_EQ(semaphore.available(), 1);
+}
@@ -0,0 +1,132 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/helpers/nothrow.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/shared_mutex.hpp>
+
+#include <gtest/gtest.h>
+
+coro::Task<void> reader(coro::SharedMutex& mutex, std::atomic<int>& readers, std::atomic<int>& maxReaders) {
+    auto lock = co_await mutex.lockShared();
+    int current = ++readers;
+    int max = maxReaders.load();
+    while (current > max && !maxReaders.compare_exchange_weak(max, current)) {
+    }
+    co_await coro::sleep(50);
+    --readers;
+}
+
+TEST(SharedMutex, ConcurrentReaders) {
+    coro::SharedMutex mutex;
+    std::atomic<int> readers = 0;
+    std::atomic<int> maxReaders = 0;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 4; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        futures.push_back(executors.back()->future(reader(mutex, readers, maxReaders)));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(maxReaders, 4);
+}
+
+coro::Task<void> readWrite(coro::SharedMutex& mutex, size_t& value, std::atomic<size_t>& mismatches) {
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 10 == 0) {
+            auto lock = co_await mutex.lock();
+            value += 2;
+        } else {
+            auto lock = co_await mutex.lockShared();
+            if (value % 2 != 0) {
+                ++mismatches;
+            }
+        }
+    }
+}
+
+TEST(SharedMutex, CrossExecutorDataRace) {
+    coro::SharedMutex mutex;
+    size_t value = 0;
+    std::atomic<size_t> mismatches = 0;
+    std::vector<coro::SerialExecutor::Ref> executors;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 10; ++i) {
+        executors.push_back(coro::SerialExecutor::create());
+        futures.push_back(executors.back()->future(readWrite(mutex, value, mismatches)));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(value, 2000);
+    EXPECT_EQ(mismatches, 0);
+}
+
+coro::Task<void> record(coro::SharedMutex& mutex, bool shared, int id, std::vector<int>& order) {
+    if (shared) {
+        auto lock = co_await mutex.lockShared();
+        order.push_back(id);
+    } else {
+        auto lock = co_await mutex.lock();
+        order.push_back(id);
+    }
+}
+
+TEST(SharedMutex, WriterPriority) {
+    auto executor = coro::SerialExecutor::create();
+    coro::SharedMutex mutex;
+    std::vector<int> order;
+    auto shared = mutex.tryLockShared();
+    ASSERT_TRUE(shared.has_value());
+    std::vector<std::future<void>> futures;
+    // readers coming after the waiting writer are queued and released together once the writer unlocks
+    futures.push_back(executor->future(record(mutex, false, 1, order)));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    EXPECT_FALSE(mutex.tryLockShared().has_value());
+    for (int id : {2, 3}) {
+        futures.push_back(executor->future(record(mutex, true, id, order)));
+        std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    }
+    futures.push_back(executor->future(record(mutex, false, 4, order)));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    shared->reset();
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector {1, 2, 3, 4}));
+    EXPECT_TRUE(mutex.tryLock().has_value());
+}
+
+TEST(SharedMutex, StopRemovesWaiter) {
+    auto executor = coro::SerialExecutor::create();
+    coro::SharedMutex mutex;
+    std::vector<int> order;
+    auto shared = mutex.tryLockShared();
+    coro::StopSource stopSource;
+    // the stopped writer should not keep the readers queued behind it waiting
+    auto stopped = executor->future(record(mutex, false, 1, order).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    auto waiting = executor->future(record(mutex, true, 2, order));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    stopSource.requestStop();
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    waiting.get();
+    EXPECT_EQ(order, (std::vector {2}));
+    shared->reset();
+    EXPECT_TRUE(mutex.tryLock().has_value());
+}
+
+TEST(SharedMutex, NoThrow) {
+    auto executor = coro::SerialExecutor::create();
+    coro::SharedMutex mutex;
+    auto unique = mutex.tryLock();
+    coro::StopSource stopSource;
+    auto future = executor->future([](coro::SharedMutex& mutex) -> coro::Task<bool> {
+        auto result = co_await coro::nothrow(mutex.lockShared());
+        co_return result.isStopped();
+    }(mutex).setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    stopSource.requestStop();
+    EXPECT_TRUE(future.get());
+}
@@ -0,0 +1,92 @@
+#include <coro/coro.hpp>
+#include <coro/executors/serial_executor.hpp>
+#include <coro/executors/thread_pool_executor.hpp>
+#include <coro/helpers/shared_task.hpp>
+#include <coro/sleep.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+coro::Task<int> compute(std::atomic<int>& runs) {
+    ++runs;
+    co_await coro::sleep(10);
+    co_return 42;
+}
+
+coro::Task<int> consume(coro::SharedTask<int> shared) {
+    const int& value = co_await shared;
+    co_return value;
+}
+
+TEST(SharedTask, ComputedOnce) {
+    auto executor = coro::SerialExecutor::create();
+    std::atomic<int> runs = 0;
+    coro::SharedTask<int> shared = compute(runs);
+    auto result = executor->syncWait([](coro::SharedTask<int> shared) -> coro::Task<std::vector<int>> {
+        co_return co_await coro::all(consume(shared), consume(shared), consume(shared));
+    }(shared));
+    EXPECT_EQ(result, (std::vector<int> {42, 42, 42}));
+    EXPECT_EQ(runs, 1);
+    EXPECT_TRUE(shared.ready());
+}
+
+TEST(SharedTask, DifferentExecutors) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    auto serial = coro::SerialExecutor::create();
+    std::atomic<int> runs = 0;
+    coro::SharedTask<int> shared = compute(runs);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 16; ++i) {
+        futures.push_back(pool->future(consume(shared)));
+        futures.push_back(serial->future(consume(shared)));
+    }
+    for (auto& future : futures) {
+        EXPECT_EQ(future.get(), 42);
+    }
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(SharedTask, LateAwaiter) {
+    auto executor = coro::SerialExecutor::create();
+    std::atomic<int> runs = 0;
+    coro::SharedTask<int> shared = compute(runs);
+    EXPECT_FALSE(shared.ready());
+    EXPECT_EQ(executor->syncWait(consume(shared)), 42);
+    EXPECT_TRUE(shared.ready());
+    // finished task is not executed again and the value is returned without suspension
+    EXPECT_EQ(executor->syncWait(consume(shared)), 42);
+    EXPECT_EQ(runs, 1);
+}
+
+coro::Task<void> fail() {
+    co_await coro::sleep(5);
+    throw std::runtime_error("failed");
+}
+
+TEST(SharedTask, Exception) {
+    auto executor = coro::SerialExecutor::create();
+    coro::SharedTask<void> shared = fail();
+    auto consumer = [](coro::SharedTask<void> shared) -> coro::Task<void> { co_await shared; };
+    auto first = executor->future(consumer(shared));
+    auto second = executor->future(consumer(shared));
+    EXPECT_THROW(first.get(), std::runtime_error);
+    EXPECT_THROW(second.get(), std::runtime_error);
+    EXPECT_THROW(executor->syncWait(consumer(shared)), std::runtime_error);
+}
+
+TEST(SharedTask, AwaiterStopped) {
+    auto executor = coro::SerialExecutor::create();
+    std::atomic<int> runs = 0;
+    coro::SharedTask<int> shared = compute(runs);
+    coro::StopSource stopSource;
+    coro::TaskContext context;
+    context.stopToken = stopSource.token();
+    auto stopped = executor->future(consume(shared).setContext(context));
+    auto other = executor->future(consume(shared));
+    stopSource.requestStop();
+    // stopping one awaiter does not cancel the shared computation
+    EXPECT_THROW(stopped.get(), coro::StopError);
+    EXPECT_EQ(other.get(), 42);
+    EXPECT_EQ(runs, 1);
+}
@@ -130,3 +130,157 @@ TEST(Stop, Reset) {
     EXPECT_THROW(future1.get(), coro::StopError);
     EXPECT_EQ(future2.get(), 42);
 }
+
+TEST(Stop, StopCallback) {
+    coro::StopSource ss;
+    int invoked = 0;
+    {
+        coro::StopCallback callback {ss.token(), [&invoked]() { ++invoked; }};
+    }
+    // unregistered on destruction
+    coro::StopCallback first {ss.token(), [&invoked]() { ++invoked; }};
+    coro::StopCallback second {ss.token(), [&invoked]() { ++invoked; }};
+    ss.requestStop();
+    EXPECT_EQ(invoked, 2);
+    ss.requestStop();
+    EXPECT_EQ(invoked, 2);
+    // registered after the stop is invoked right away
+    coro::StopCallback late {ss.token(), [&invoked]() { ++invoked; }};
+    EXPECT_EQ(invoked, 3);
+    // null token never invokes
+    coro::StopCallback none {coro::StopToken {}, [&invoked]() { ++invoked; }};
+    EXPECT_EQ(invoked, 3);
+}
+
+TEST(Stop, CallbackReleasedByItself) {
+    coro::StopSource ss;
+    coro::Callback::Ref callback;
+    callback = ss.token().addStopCallback([&callback]() { callback.reset(); });
+    coro::Callback::Ref other = ss.token().addStopCallback([]() {});
+    ss.requestStop();
+    EXPECT_EQ(callback, nullptr);
+}
+
+TEST(Stop, DestroyWhileInvoked) {
+    using namespace std::chrono_literals;
+    coro::StopSource ss;
+    std::atomic<bool> started = false;
+    std::atomic<bool> finished = false;
+    auto callback = std::make_unique<coro::StopCallback<std::function<void()>>>(ss.token(), [&]() {
+        started = true;
+        std::this_thread::sleep_for(20ms);
+        finished = true;
+    });
+    std::thread stopper {[&ss]() { ss.requestStop(); }};
+    while (!started) {
+        std::this_thread::yield();
+    }
+    // waits till the invocation on the other thread is complete
+    callback.reset();
+    EXPECT_TRUE(finished);
+    stopper.join();
+}
+
+TEST(Stop, ContendedRegistration) {
+    coro::StopSource ss;
+    std::atomic<int> invoked = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&ss, &invoked]() {
+            for (int i = 0; i < 10000; ++i) {
+                coro::StopCallback callback {ss.token(), [&invoked]() { ++invoked; }};
+            }
+        });
+    }
+    coro::StopCallback kept {ss.token(), [&invoked]() { ++invoked; }};
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(invoked, 0);
+    ss.requestStop();
+    EXPECT_EQ(invoked, 1);
+}
+
+TEST(Stop, Linked) {
+    coro::StopSource root;
+    auto child = coro::StopSource::linked(root.token());
+    auto grandChild = coro::StopSource::linked(child.token());
+    auto sibling = coro::StopSource::linked(root.token());
+    int invoked = 0;
+    coro::StopCallback callback {grandChild.token(), [&invoked]() { ++invoked; }};
+
+    // stopping the child does not affect the parent
+    sibling.requestStop();
+    EXPECT_TRUE(sibling.stopRequested());
+    EXPECT_FALSE(root.stopRequested());
+
+    auto unlinked = coro::StopSource::linked(root.token());
+    unlinked.unlink();
+    {
+        // destroyed child is detached from the parent
+        auto destroyed = coro::StopSource::linked(child.token());
+    }
+
+    root.requestStop();
+    EXPECT_TRUE(child.stopRequested());
+    EXPECT_TRUE(grandChild.stopRequested());
+    EXPECT_FALSE(unlinked.stopRequested());
+    EXPECT_EQ(invoked, 1);
+
+    // linking to the stopped parent stops right away
+    auto late = coro::StopSource::linked(root.token());
+    EXPECT_TRUE(late.stopRequested());
+}
+
+TEST(Stop, LinkedTree) {
+    coro::StopSource root;
+    std::vector<coro::StopSource> nodes;
+    nodes.reserve(100000);
+    nodes.push_back(coro::StopSource::linked(root.token()));
+    for (size_t i = 1; i < nodes.capacity(); ++i) {
+        nodes.push_back(coro::StopSource::linked(nodes[(i - 1) / 8].token()));
+    }
+    root.requestStop();
+    for (auto& node : nodes) {
+        EXPECT_TRUE(node.stopRequested());
+    }
+}
+
+TEST(Stop, LinkStopTokens) {
+    auto executor = coro::SerialExecutor::create();
+    coro::StopSource parentSource;
+    coro::StopSource childSource;
+    coro::StopSource otherSource;
+    std::atomic<int> stopped = 0;
+    auto child = [](coro::StopToken token, std::atomic<int>& stopped) -> coro::Task<void> {
+        const coro::TaskContext& context = co_await coro::currentContext;
+        // the own token is kept
+        EXPECT_EQ(context.stopToken, token);
+        try {
+            co_await coro::sleep(1000);
+        } catch (const coro::StopError&) {
+            ++stopped;
+        }
+    };
+    auto parent = [&]() -> coro::Task<void> {
+        co_await child(childSource.token(), stopped).setStopToken(childSource.token());
+        co_await child(otherSource.token(), stopped).setStopToken(otherSource.token());
+    };
+    coro::TaskContext context;
+    context.stopToken = parentSource.token();
+    context.linkStopTokens = true;
+    auto future = executor->future(parent().setContext(context));
+
+    using namespace std::chrono_literals;
+    std::this_thread::sleep_for(20ms);
+    // the first child is stopped on its own, and the parent continues
+    childSource.requestStop();
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(stopped, 1);
+    EXPECT_FALSE(parentSource.stopRequested());
+    // the second child is stopped along with the parent
+    parentSource.requestStop();
+    EXPECT_THROW(future.get(), coro::StopError);
+    EXPECT_EQ(stopped, 2);
+    EXPECT_TRUE(otherSource.stopRequested());
+}
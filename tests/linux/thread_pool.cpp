@@ -0,0 +1,79 @@
+#include <coro/coro.hpp>
+#include <coro/executors/thread_pool_executor.hpp>
+#include <coro/sleep.hpp>
+#include <coro/sync/mutex.hpp>
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+coro::Task<int> leaf(int x) {
+    co_return x;
+}
+
+coro::Task<int> sum(int n) {
+    int result = 0;
+    for (int i = 0; i < n; ++i) {
+        result += co_await leaf(i);
+    }
+    co_return result;
+}
+
+TEST(ThreadPool, SyncWait) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    EXPECT_EQ(pool->size(), 4);
+    EXPECT_EQ(pool->syncWait(sum(100)), 4950);
+}
+
+coro::Task<std::thread::id> threadId() {
+    std::this_thread::sleep_for(std::chrono::milliseconds {5});
+    co_return std::this_thread::get_id();
+}
+
+TEST(ThreadPool, RunsInParallel) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    std::vector<std::future<std::thread::id>> futures;
+    for (int i = 0; i < 32; ++i) {
+        futures.push_back(pool->future(threadId()));
+    }
+    std::set<std::thread::id> threads;
+    for (auto& future : futures) {
+        threads.insert(future.get());
+    }
+    EXPECT_GT(threads.size(), 1);
+}
+
+coro::Task<void> advance(size_t& counter, coro::Mutex& mutex) {
+    for (int i = 0; i < 1000; ++i) {
+        auto lock = co_await mutex;
+        ++counter;
+    }
+}
+
+TEST(ThreadPool, Mutex) {
+    auto pool = coro::ThreadPoolExecutor::create(4);
+    coro::Mutex mutex;
+    size_t counter = 0;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.push_back(pool->future(advance(counter, mutex)));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(counter, 8000);
+}
+
+coro::Task<int> sleepy() {
+    co_await coro::sleep(1000);
+    co_return 42;
+}
+
+TEST(ThreadPool, Cancellation) {
+    auto pool = coro::ThreadPoolExecutor::create(2);
+    coro::StopSource stopSource;
+    auto future = pool->future(sleepy().setStopToken(stopSource.token()));
+    std::this_thread::sleep_for(std::chrono::milliseconds {20});
+    stopSource.requestStop();
+    EXPECT_THROW(future.get(), coro::StopError);
+}